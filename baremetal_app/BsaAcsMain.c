@@ -184,6 +184,8 @@ void
 freeBsaAcsMem()
 {
 
+  /* Powers off the parked PE pool, needs the PE info table */
+  val_free_shared_mem();
   val_pe_free_info_table();
   val_gic_free_info_table();
   val_timer_free_info_table();
@@ -193,7 +195,6 @@ freeBsaAcsMem()
   val_peripheral_free_info_table();
   val_smbios_free_info_table();
   val_dma_free_info_table();
-  val_free_shared_mem();
 }
 
 /***
@@ -211,6 +212,7 @@ ShellAppMainbsa(
 
   uint32_t             Status;
   void                 *branch_label;
+  uint64_t             heap_live, heap_peak;
 
   g_print_level = PLATFORM_OVERRIDE_PRINT_LEVEL;
 
@@ -351,6 +353,12 @@ print_test_status:
   val_print(ACS_PRINT_ERR, "  Tests Failed = %4d\n", g_acs_tests_fail);
   val_print(ACS_PRINT_ERR, "     -------------------------------------------------------\n", 0);
 
+  val_profile_report();
+
+  val_memory_heap_stats(&heap_live, &heap_peak);
+  val_print(ACS_PRINT_DEBUG, "\n     Heap : %ld bytes live", heap_live);
+  val_print(ACS_PRINT_DEBUG, ", %ld bytes peak\n", heap_peak);
+
   freeBsaAcsMem();
 
   val_print(ACS_PRINT_ERR, "\n      *** BSA tests complete. Reset the system. ***\n\n", 0);
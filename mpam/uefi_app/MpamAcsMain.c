@@ -157,13 +157,14 @@ VOID
 FreeMpamAcsMem (
 )
 {
+    /* Powers off the parked PE pool, needs the PE info table */
+    val_free_shared_mem();
     val_pe_free_info_table();
     val_gic_free_info_table();
     val_mpam_free_info_table();
     val_hmat_free_info_table();
     val_srat_free_info_table();
     val_pcc_free_info_table();
-    val_free_shared_mem();
 }
 
 VOID
@@ -65,6 +65,12 @@ void *pal_aligned_alloc( uint32_t alignment, uint32_t size );
 #ifdef TARGET_BM_BOOT
 void pal_uart_print(int log, const char *fmt, ...);
 void *mem_alloc(size_t alignment, size_t size);
+void mem_free(void *ptr);
+void mem_heap_init(uint64_t base, uint64_t size);
+uint32_t mem_arena_checkpoint(void);
+uint64_t mem_arena_release(uint32_t checkpoint);
+void mem_arena_keep(void *ptr);
+void mem_heap_stats(uint64_t *live, uint64_t *peak);
 #define print(verbose, string, ...)  if(verbose >= g_print_level) \
                                                    pal_uart_print(verbose, string, ##__VA_ARGS__)
 #else
@@ -0,0 +1,406 @@
+/** @file
+ * Copyright (c) 2024-2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pal_common_support.h"
+#include "platform_image_def.h"
+#include "platform_override_fvp.h"
+
+#define __ADDR_ALIGN_MASK(a, mask)    (((a) + (mask)) & ~(mask))
+#define ADDR_ALIGN(a, b)              __ADDR_ALIGN_MASK(a, (typeof(a))(b) - 1)
+
+/* Functions implemented below are used to allocate memory from heap. Baremetal implementation
+   of memory allocation.
+
+   The heap is a contiguous run of blocks carved from a bump pointer, each block starting with
+   a heap_block_t header. Freed blocks are kept on size-class free lists, class n holding blocks
+   of 2^n to 2^(n+1) - 1 bytes, and are split when reused. The word before every returned pointer
+   holds the address of its block header, which lets a block serve any alignment.
+   Blocks are tagged with the arena epoch they were allocated in, so the blocks a test leaves
+   allocated can be reported and reclaimed by mem_arena_release().
+*/
+
+#define HEAP_BLOCK_USED     0x55534544    /* "USED" */
+#define HEAP_BLOCK_FREE     0x46524545    /* "FREE" */
+#define HEAP_NUM_CLASSES    40
+#define HEAP_MIN_BLOCK      64            /* smaller remainders stay with the allocated block */
+#define HEAP_MIN_ALIGN      8
+
+#ifndef PLATFORM_OVERRIDE_HEAP_ARENA_RESET
+#define PLATFORM_OVERRIDE_HEAP_ARENA_RESET  0
+#endif
+
+typedef struct heap_block {
+    uint64_t size;              /* Bytes from this header to the next block */
+    uint32_t state;             /* HEAP_BLOCK_USED or HEAP_BLOCK_FREE */
+    uint32_t epoch;             /* Arena epoch of the allocation */
+    struct heap_block *next;    /* Free list link, valid while the block is free */
+} heap_block_t;
+
+static uint64_t heap_start;
+static uint64_t heap_base;      /* Bump pointer, end of the last block */
+static uint64_t heap_top;
+static uint64_t heap_init_done = 0;
+static uint64_t heap_live;
+static uint64_t heap_peak;
+static uint32_t heap_epoch;
+static heap_block_t *heap_free_list[HEAP_NUM_CLASSES];
+
+static int is_power_of_2(uint32_t n)
+{
+    return n && !(n & (n - 1));
+}
+
+/**
+ * @brief  Size class of a block, floor(log2(size)).
+ * @param  size - Block size in bytes.
+ * @return Free list index.
+ **/
+static uint32_t heap_class(uint64_t size)
+{
+    uint32_t class = 0;
+
+    while ((size >> (class + 1)) && (class < HEAP_NUM_CLASSES - 1))
+        class++;
+
+    return class;
+}
+
+/**
+ * @brief  Address returned for an allocation placed in the block at start.
+ * @param  start - Block start address.
+ * @param  alignment - Alignment of the returned address.
+ * @return Aligned address leaving room for the header and the back pointer.
+ **/
+static uint64_t heap_payload(uint64_t start, size_t alignment)
+{
+    return ADDR_ALIGN(start + sizeof(heap_block_t) + sizeof(uint64_t), alignment);
+}
+
+/**
+ * @brief  Put a block on the free list of its size class.
+ * @param  start - Block start address.
+ * @param  size - Block size in bytes.
+ * @return Void
+ **/
+static void heap_insert_free(uint64_t start, uint64_t size)
+{
+    heap_block_t *block = (heap_block_t *)start;
+    uint32_t class = heap_class(size);
+
+    block->size = size;
+    block->state = HEAP_BLOCK_FREE;
+    block->next = heap_free_list[class];
+    heap_free_list[class] = block;
+}
+
+/**
+ * @brief  Place an allocation in the free range [start, start + len). Leading alignment
+ *         padding and a trailing remainder of at least HEAP_MIN_BLOCK are returned to
+ *         the free lists.
+ * @param  start - Start of the free range.
+ * @param  len - Length of the free range.
+ * @param  alignment - Alignment of the returned address.
+ * @param  size - Requested size in bytes.
+ * @return Allocated address.
+ **/
+static void *heap_carve(uint64_t start, uint64_t len, size_t alignment, size_t size)
+{
+    heap_block_t *block;
+    uint64_t payload = heap_payload(start, alignment);
+    uint64_t header = payload - sizeof(uint64_t) - sizeof(heap_block_t);
+    uint64_t end = ADDR_ALIGN(payload + size, HEAP_MIN_ALIGN);
+
+    if ((header - start) >= HEAP_MIN_BLOCK) {
+        heap_insert_free(start, header - start);
+        len -= header - start;
+        start = header;
+    }
+
+    if (((start + len) - end) >= HEAP_MIN_BLOCK) {
+        heap_insert_free(end, (start + len) - end);
+        len = end - start;
+    }
+
+    block = (heap_block_t *)start;
+    block->size = len;
+    block->state = HEAP_BLOCK_USED;
+    block->epoch = heap_epoch;
+    block->next = NULL;
+    ((uint64_t *)payload)[-1] = start;
+
+    heap_live += len;
+    if (heap_live > heap_peak)
+        heap_peak = heap_live;
+
+    return (void *)payload;
+}
+
+/**
+ * @brief  Walk the heap, merge adjacent free blocks, rebuild the free lists and give
+ *         trailing free space back to the bump pointer.
+ * @param  void
+ * @return Void
+ **/
+static void heap_coalesce(void)
+{
+    uint64_t addr = heap_start;
+    uint64_t free_start = 0;
+    heap_block_t *block;
+    uint32_t class;
+
+    for (class = 0; class < HEAP_NUM_CLASSES; class++)
+        heap_free_list[class] = NULL;
+
+    while (addr < heap_base) {
+        block = (heap_block_t *)addr;
+        if (block->state == HEAP_BLOCK_FREE) {
+            if (!free_start)
+                free_start = addr;
+        } else if (free_start) {
+            heap_insert_free(free_start, addr - free_start);
+            free_start = 0;
+        }
+        addr += block->size;
+    }
+
+    if (free_start)
+        heap_base = free_start;
+}
+
+/**
+ * @brief  Initialise the heap over the region [base, base + size).
+ *         The platform heap is used by default, a host build can point it at
+ *         a malloc'd region instead.
+ * @param  base - Start of the heap region.
+ * @param  size - Size of the heap region.
+ * @return Void
+ **/
+void mem_heap_init(uint64_t base, uint64_t size)
+{
+    uint32_t class;
+
+    heap_start = ADDR_ALIGN(base, HEAP_MIN_ALIGN);
+    heap_base = heap_start;
+    heap_top = base + size;
+    heap_live = 0;
+    heap_peak = 0;
+    heap_epoch = 0;
+    for (class = 0; class < HEAP_NUM_CLASSES; class++)
+        heap_free_list[class] = NULL;
+    heap_init_done = 1;
+}
+
+/**
+ * @brief  Initialisation of allocation data structure
+ * @param  void
+ * @return Void
+ **/
+void mem_alloc_init(void)
+{
+    mem_heap_init(PLATFORM_HEAP_REGION_BASE, PLATFORM_HEAP_REGION_SIZE);
+}
+
+/**
+ * @brief Allocates contiguous memory of requested size from the free lists, or from
+ *        the top of the heap if no free block fits.
+ * @param alignment - alignment for the address. It must be in power of 2.
+ * @param Size - Size of the region. It must not be zero.
+ * @return - Returns allocated memory base address if allocation is successful.
+ *           Otherwise returns NULL.
+ **/
+void *heap_alloc(size_t alignment, size_t size)
+{
+    heap_block_t *block, *prev;
+    uint64_t start, end;
+    uint32_t class;
+
+    class = heap_class(size + sizeof(heap_block_t) + sizeof(uint64_t));
+    for (; class < HEAP_NUM_CLASSES; class++) {
+        prev = NULL;
+        for (block = heap_free_list[class]; block != NULL; prev = block, block = block->next) {
+            start = (uint64_t)block;
+            if ((heap_payload(start, alignment) + size) > (start + block->size))
+                continue;
+
+            if (prev)
+                prev->next = block->next;
+            else
+                heap_free_list[class] = block->next;
+
+            return heap_carve(start, block->size, alignment, size);
+        }
+    }
+
+    start = heap_base;
+    end = ADDR_ALIGN(heap_payload(start, alignment) + size, HEAP_MIN_ALIGN);
+    if ((end > heap_top) || (end < start))
+        return NULL;
+
+    heap_base = end;
+
+    return heap_carve(start, end - start, alignment, size);
+}
+
+/**
+ * @brief Allocates contiguous memory of requested size(no_of_bytes) and alignment.
+ * @param alignment - alignment for the address. It must be in power of 2.
+ * @param Size - Size of the region. It must not be zero.
+ * @return - Returns allocated memory base address if allocation is successful.
+ *           Otherwise returns NULL.
+ **/
+void *mem_alloc(size_t alignment, size_t size)
+{
+  void *addr = NULL;
+
+  if(heap_init_done != 1)
+    mem_alloc_init();
+
+  if (size <= 0)
+  {
+    return NULL;
+  }
+
+  if (!is_power_of_2((uint32_t)alignment))
+  {
+    return NULL;
+  }
+
+  if (alignment < HEAP_MIN_ALIGN)
+    alignment = HEAP_MIN_ALIGN;
+
+  addr = heap_alloc(alignment, size);
+
+  /* Free blocks may only fit once merged with their neighbours */
+  if (addr == NULL) {
+    heap_coalesce();
+    addr = heap_alloc(alignment, size);
+  }
+
+  return addr;
+}
+
+/**
+ * @brief  Free the memory for given memory address. Blocks at the top of the heap go
+ *         back to the bump pointer, others to the free list of their size class.
+ *         Pointers not returned by mem_alloc and double frees are ignored.
+ * @param  ptr - Address returned by mem_alloc.
+ * @return Void
+ **/
+void mem_free(void *ptr)
+{
+  heap_block_t *block;
+
+  if (!ptr || (heap_init_done != 1))
+    return;
+
+  block = (heap_block_t *)((uint64_t *)ptr)[-1];
+  if (((uint64_t)block < heap_start) || ((uint64_t)block >= heap_base) ||
+      (block->state != HEAP_BLOCK_USED))
+    return;
+
+  heap_live -= block->size;
+
+  if (((uint64_t)block + block->size) == heap_base)
+    heap_base = (uint64_t)block;
+  else
+    heap_insert_free((uint64_t)block, block->size);
+}
+
+/**
+ * @brief  Start a new arena, blocks allocated from now on are tagged with it.
+ * @param  void
+ * @return Checkpoint to pass to mem_arena_release.
+ **/
+uint32_t mem_arena_checkpoint(void)
+{
+  return ++heap_epoch;
+}
+
+/**
+ * @brief  Take a block out of every arena. Used for allocations made during a test which
+ *         outlive it, such as lookup tables built on first use, so that they are neither
+ *         reported nor reclaimed by mem_arena_release.
+ * @param  ptr - Address returned by mem_alloc.
+ * @return Void
+ **/
+void mem_arena_keep(void *ptr)
+{
+  heap_block_t *block;
+
+  if (!ptr || (heap_init_done != 1))
+    return;
+
+  block = (heap_block_t *)((uint64_t *)ptr)[-1];
+  if (((uint64_t)block < heap_start) || ((uint64_t)block >= heap_base) ||
+      (block->state != HEAP_BLOCK_USED))
+    return;
+
+  /* Checkpoints start at 1, epoch 0 is older than every arena */
+  block->epoch = 0;
+}
+
+/**
+ * @brief  Close the arena opened by mem_arena_checkpoint. The blocks allocated in it
+ *         and not freed are reclaimed if PLATFORM_OVERRIDE_HEAP_ARENA_RESET is set,
+ *         except those passed to mem_arena_keep.
+ * @param  checkpoint - Value returned by mem_arena_checkpoint.
+ * @return Bytes still allocated in the arena.
+ **/
+uint64_t mem_arena_release(uint32_t checkpoint)
+{
+  uint64_t addr = heap_start;
+  uint64_t leaked = 0;
+  heap_block_t *block;
+
+  if ((heap_init_done != 1) || (checkpoint == 0))
+    return 0;
+
+  while (addr < heap_base) {
+    block = (heap_block_t *)addr;
+    if ((block->state == HEAP_BLOCK_USED) && (block->epoch >= checkpoint)) {
+      leaked += block->size;
+      if (PLATFORM_OVERRIDE_HEAP_ARENA_RESET) {
+        block->state = HEAP_BLOCK_FREE;
+        heap_live -= block->size;
+      }
+    }
+    addr += block->size;
+  }
+
+  if (PLATFORM_OVERRIDE_HEAP_ARENA_RESET && leaked)
+    heap_coalesce();
+
+  /* Later allocations belong to no arena until the next checkpoint. The epoch only
+     moves forward, so blocks kept past this release are never reported again. */
+  heap_epoch++;
+
+  return leaked;
+}
+
+/**
+ * @brief  Heap usage statistics.
+ * @param  live - Bytes currently allocated, including block headers.
+ * @param  peak - Highest value of live since the heap was initialised.
+ * @return Void
+ **/
+void mem_heap_stats(uint64_t *live, uint64_t *peak)
+{
+  *live = heap_live;
+  *peak = heap_peak;
+}
@@ -327,6 +327,79 @@ pal_mem_calloc(uint32_t num, uint32_t Size)
 }
 
 
+/**
+  @brief  Open a heap arena, memory allocated from now on is accounted to it
+
+  @param  None
+
+  @return Checkpoint to pass to pal_mem_arena_release
+**/
+uint32_t
+pal_mem_arena_checkpoint(void)
+{
+#ifndef TARGET_BM_BOOT
+  return 0;
+#else
+  return mem_arena_checkpoint();
+#endif
+}
+
+/**
+  @brief  Close a heap arena. Memory allocated in it and not freed is
+          reclaimed if the platform sets PLATFORM_OVERRIDE_HEAP_ARENA_RESET
+
+  @param  checkpoint  value returned by pal_mem_arena_checkpoint
+
+  @return Bytes left allocated in the arena
+**/
+uint64_t
+pal_mem_arena_release(uint32_t checkpoint)
+{
+#ifndef TARGET_BM_BOOT
+  (void) checkpoint;
+  return 0;
+#else
+  return mem_arena_release(checkpoint);
+#endif
+}
+
+/**
+  @brief  Take a buffer out of the heap arenas, it is kept when the arena it
+          was allocated in is released
+
+  @param  Buffer  address returned by pal_mem_alloc or pal_mem_calloc
+
+  @return None
+**/
+void
+pal_mem_arena_keep(void *Buffer)
+{
+#ifndef TARGET_BM_BOOT
+  (void) Buffer;
+#else
+  mem_arena_keep(Buffer);
+#endif
+}
+
+/**
+  @brief  Heap usage statistics
+
+  @param  live  bytes currently allocated
+  @param  peak  highest number of bytes allocated at once
+
+  @return None
+**/
+void
+pal_mem_heap_stats(uint64_t *live, uint64_t *peak)
+{
+#ifndef TARGET_BM_BOOT
+  *live = 0;
+  *peak = 0;
+#else
+  mem_heap_stats(live, peak);
+#endif
+}
+
 /**
   @brief  Allocate memory which is to be used to share data across PEs
 
@@ -64,6 +64,28 @@ pal_pcie_create_info_table(PCIE_INFO_TABLE *PcieTable)
   return;
 }
 
+/**
+  @brief  Release the PAL state built while the PCIe info table is in use.
+          The platform tables of baremetal are static, nothing to release.
+
+  @return None
+**/
+void
+pal_pcie_free_info_table(void)
+{
+}
+
+/**
+  @brief  Returns the number of ECAM regions of the platform PCIe configuration
+
+  @return Number of ECAM regions
+**/
+uint32_t
+pal_pcie_get_num_ecam(void)
+{
+  return platform_pcie_cfg.num_entries;
+}
+
 /**
   @brief  Returns the ECAM address of the input PCIe bridge function
 
@@ -98,6 +98,11 @@ pal_mem_free_cacheable(uint32_t Bdf, uint32_t Size, void *Va, void *Pa)
   */
 
   gBS->FreePages((EFI_PHYSICAL_ADDRESS)(UINTN)Va, EFI_SIZE_TO_PAGES(Size));
+#elif defined (TARGET_BM_BOOT)
+  (void) Bdf;
+  (void) Size;
+  (void) Pa;
+  mem_free(Va);
 #else
   (void) Bdf;
   (void) Size;
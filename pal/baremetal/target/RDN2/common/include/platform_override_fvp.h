@@ -31,6 +31,10 @@
 #define PLATFORM_OVERRIDE_MMU_PGT_IAS   48
 #define PLATFORM_OVERRIDE_MMU_PGT_OAS   48
 
+/* Heap config parameters. Set to 1 to reclaim the heap memory a test leaves allocated
+   when the test ends, 0 only reports it at debug verbosity */
+#define PLATFORM_OVERRIDE_HEAP_ARENA_RESET  0
+
 /* PE platform config paramaters */
 #define PLATFORM_OVERRIDE_PE_CNT           16
 #define PLATFORM_OVERRIDE_PE0_INDEX        0x0
@@ -271,6 +275,10 @@
 #define PLATFORM_BM_OVERRIDE_TIMEOUT_LARGE         0x10000
 #define PLATFORM_BM_OVERRIDE_TIMEOUT_MEDIUM        0x1000
 #define PLATFORM_BM_OVERRIDE_TIMEOUT_SMALL         0x10
+/* Timeout values in microseconds for waits bounded by the generic counter */
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_US_LARGE      10000000
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_US_MEDIUM     1000000
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_US_SMALL      1000
 
 /* Sample macros for ECAM_1
  * #define PLATFORM_OVERRIDE_PCIE_ECAM_BASE_ADDR_1  0x00000000
@@ -41,6 +41,12 @@
 #define PLATFORM_OVERRIDE_TIMEOUT_MEDIUM 0x1000
 #define PLATFORM_OVERRIDE_TIMEOUT_SMALL  0x10
 
+/* Change OVERRIDE to 1 and define the Timeout values in microseconds to be used */
+#define PLATFORM_OVERRIDE_TIMEOUT_US        0
+#define PLATFORM_OVERRIDE_TIMEOUT_US_LARGE  10000000
+#define PLATFORM_OVERRIDE_TIMEOUT_US_MEDIUM 1000000
+#define PLATFORM_OVERRIDE_TIMEOUT_US_SMALL  1000
+
 #define PLATFORM_OVERRIDE_EL2_VIR_TIMER_GSIV  28
 
 
@@ -0,0 +1,39 @@
+/** @file
+ * Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#ifndef __PAL_SIM_H__
+#define __PAL_SIM_H__
+
+#include <stdint.h>
+
+/* Number of ECAM regions a snapshot can describe */
+#ifndef PAL_SIM_MAX_ECAM
+#define PAL_SIM_MAX_ECAM       16
+#endif
+
+/* Number of functions described to pal_pcie_check_device_list */
+#ifndef PAL_SIM_MAX_PCIE_DEV
+#define PAL_SIM_MAX_PCIE_DEV   256
+#endif
+
+uint32_t pal_sim_pcie_load(const char *path);
+void     pal_sim_pcie_free(void);
+void     pal_sim_pcie_get_stats(uint64_t *cfg_reads, uint64_t *cfg_writes);
+uint32_t pal_sim_pcie_cfg_read(uint64_t addr, uint32_t *data);
+uint32_t pal_sim_pcie_cfg_write(uint64_t addr, uint32_t data);
+
+#endif
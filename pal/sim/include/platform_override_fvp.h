@@ -0,0 +1,56 @@
+/** @file
+ * Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#ifndef __PLATFORM_OVERRIDE_FVP_H__
+#define __PLATFORM_OVERRIDE_FVP_H__
+
+#include "pal_sim.h"
+
+/* Platform description of the simulated ECAM backend. The ECAM regions and the
+   functions behind them come from the snapshot given to pal_sim_pcie_load(). */
+
+/* PCIE platform config parameters */
+#define PLATFORM_OVERRIDE_NUM_ECAM                PAL_SIM_MAX_ECAM
+#define PLATFORM_MAX_HB_COUNT                     1
+
+/* Offset from the memory range to be accesed */
+#define MEM_OFFSET_SMALL   0x10
+#define MEM_OFFSET_MEDIUM  0x1000
+
+#define PLATFORM_BM_OVERRIDE_PCIE_MAX_BUS      256
+#define PLATFORM_BM_OVERRIDE_PCIE_MAX_DEV      32
+#define PLATFORM_BM_OVERRIDE_PCIE_MAX_FUNC     8
+
+// This value is arbitrary and may have to be adjusted
+#define PLATFORM_BM_OVERRIDE_MAX_IRQ_CNT       0xFFFF
+
+#define PLATFORM_OVERRIDE_MAX_SID              24
+
+#define PLATFORM_OVERRIDE_TIMEOUT              0
+/* Define the Timeout values to be used */
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_LARGE         0x10000
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_MEDIUM        0x1000
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_SMALL         0x10
+/* Timeout values in microseconds for waits bounded by the generic counter */
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_US_LARGE      10000000
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_US_MEDIUM     1000000
+#define PLATFORM_BM_OVERRIDE_TIMEOUT_US_SMALL      1000
+
+/* No exerciser is simulated, pal_is_bdf_exerciser() reports none */
+#define TEST_REG_COUNT              10
+
+#endif
@@ -0,0 +1,87 @@
+/** @file
+ * Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#ifndef __PLATFORM_OVERRIDE_STRUCT_H__
+#define __PLATFORM_OVERRIDE_STRUCT_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include "platform_override_fvp.h"
+
+typedef struct {
+  uint32_t   hb_enteries;                              ///< No. of HB's in the ECAM
+  uint32_t   segment_num[PLATFORM_MAX_HB_COUNT];       ///< Segment number of the ECAM
+  uint32_t   start_bus_num[PLATFORM_MAX_HB_COUNT];     ///< Start Bus number for this ecam space
+  uint32_t   end_bus_num[PLATFORM_MAX_HB_COUNT];       ///< Last Bus number
+  uint64_t   ep_bar64_value[PLATFORM_MAX_HB_COUNT];    ///< Prefetch 64bit BAR address for EP
+  uint64_t   rp_bar64_value[PLATFORM_MAX_HB_COUNT];    ///< 64bit BAR address for RP
+  uint32_t   ep_npbar32_value[PLATFORM_MAX_HB_COUNT];  ///< Non-Prefetch 32bit BAR address for EP
+  uint32_t   ep_pbar32_value[PLATFORM_MAX_HB_COUNT];   ///< Prefetch 32bit BAR address for EP
+  uint32_t   rp_bar32_value[PLATFORM_MAX_HB_COUNT];    ///< 32bit BAR address for RP
+} PCIE_ROOT_INFO_BLOCK;
+
+typedef struct {
+  PCIE_ROOT_INFO_BLOCK block[PLATFORM_OVERRIDE_NUM_ECAM];
+} PCIE_ROOT_INFO_TABLE;
+
+struct ecam_reg_data {
+    uint32_t offset;    //Offset into 4096 bytes ecam config reg space
+    uint32_t attribute;
+    uint32_t value;
+};
+
+struct exerciser_data_cfg_space {
+    struct ecam_reg_data reg[TEST_REG_COUNT];
+};
+
+typedef enum {
+    MMIO_PREFETCHABLE = 0x0,
+    MMIO_NON_PREFETCHABLE = 0x1
+} BAR_MEM_TYPE;
+
+struct exerciser_data_bar_space {
+    void *base_addr;
+    BAR_MEM_TYPE type;
+};
+
+typedef enum {
+  MMIO = 0,
+  IO = 1
+} BAR_MEM_INDICATOR_TYPE;
+
+typedef enum {
+  BITS_32 = 0,
+  BITS_64 = 2
+} BAR_MEM_DECODE_TYPE;
+
+typedef union exerciser_data {
+    struct exerciser_data_cfg_space cfg_space;
+    struct exerciser_data_bar_space bar_space;
+} exerciser_data_t;
+
+typedef enum {
+    EXERCISER_DATA_CFG_SPACE = 0x1,
+    EXERCISER_DATA_BAR0_SPACE = 0x2,
+    EXERCISER_DATA_MMIO_SPACE = 0x3,
+} EXERCISER_DATA_TYPE;
+
+typedef enum {
+    ACCESS_TYPE_RD = 0x0,
+    ACCESS_TYPE_RW = 0x1
+} ECAM_REG_ATTRIBUTE;
+
+#endif
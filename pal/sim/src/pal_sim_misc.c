@@ -0,0 +1,228 @@
+/** @file
+ * Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include "pal_pcie_enum.h"
+#include "pal_common_support.h"
+#include "platform_override_struct.h"
+#include "pal_sim.h"
+
+/* Host side of the platform services used by the PCIe PAL. MMIO outside the
+   simulated ECAM reads as all ones and ignores writes, as an unmapped bus does. */
+
+uint32_t g_print_level = ACS_PRINT_TEST;
+uint32_t g_print_mmio;
+uint32_t g_curr_module;
+uint32_t g_enable_module;
+
+/**
+  @brief  Read 32-bit data from an address, served by the simulated ECAM.
+
+  @param  addr  Address to read
+
+  @return Data read
+**/
+uint32_t
+pal_mmio_read(uint64_t addr)
+{
+  uint32_t data;
+
+  if (!pal_sim_pcie_cfg_read(addr, &data)) {
+      print(ACS_PRINT_WARN, "\n No simulated device at address 0x%lx", (unsigned long)addr);
+      data = PCIE_UNKNOWN_RESPONSE;
+  }
+
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(ACS_PRINT_INFO, " pal_mmio_read Address = %lx", (unsigned long)addr);
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(ACS_PRINT_INFO, "  Data = %x\n", data);
+
+  return data;
+}
+
+/**
+  @brief  Write 32-bit data to an address, served by the simulated ECAM.
+
+  @param  addr  Address to write
+  @param  data  Data to write
+
+  @return None
+**/
+void
+pal_mmio_write(uint64_t addr, uint32_t data)
+{
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(ACS_PRINT_INFO, " pal_mmio_write Address = %lx", (unsigned long)addr);
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(ACS_PRINT_INFO, "  Data = %x\n", data);
+
+  if (!pal_sim_pcie_cfg_write(addr, data))
+      print(ACS_PRINT_WARN, "\n No simulated device at address 0x%lx", (unsigned long)addr);
+}
+
+/**
+  @brief  Copies a source buffer to a destination buffer.
+
+  @param  DestinationBuffer  Destination of the copy
+  @param  SourceBuffer       Source of the copy
+  @param  Length             Number of bytes to copy
+
+  @return DestinationBuffer
+**/
+void *
+pal_memcpy(void *DestinationBuffer, const void *SourceBuffer, uint32_t Length)
+{
+  return memcpy(DestinationBuffer, SourceBuffer, Length);
+}
+
+/**
+  @brief  Allocates memory with the given alignment.
+
+  @param  alignment  Alignment of the buffer, a power of 2
+  @param  size       Requested size in bytes
+
+  @return Pointer to the buffer, NULL on failure
+**/
+void *
+pal_aligned_alloc(uint32_t alignment, uint32_t size)
+{
+  /* aligned_alloc requires a size that is a multiple of the alignment */
+  return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+/**
+  @brief  Frees a buffer allocated by pal_aligned_alloc.
+
+  @param  Buffer  Buffer to free
+
+  @return None
+**/
+void
+pal_mem_free_aligned(void *Buffer)
+{
+  free(Buffer);
+}
+
+/**
+  @brief   This API checks the PCIe hierarchy fo P2P support
+  @return  1 - P2P feature not supported 0 - P2P feature supported
+**/
+uint32_t
+pal_pcie_p2p_support(void)
+{
+  return 0;
+}
+
+/**
+    @brief   Return if driver present for pcie device
+    @param   seg        PCI segment number
+    @param   bus        PCI bus address
+    @param   dev        PCI device address
+    @param   fn         PCI function number
+    @return  Driver present : 0 or 1
+**/
+uint32_t
+pal_pcie_device_driver_present(uint32_t seg, uint32_t bus, uint32_t dev, uint32_t fn)
+{
+  (void) seg;
+  (void) bus;
+  (void) dev;
+  (void) fn;
+
+  return 1;
+}
+
+/**
+    @brief   Create a list of MSI(X) vectors for a device. Interrupts are not simulated.
+
+    @param   Seg        PCI segment number
+    @param   Bus        PCI bus address
+    @param   Dev        PCI device address
+    @param   Fn         PCI function number
+    @param   MVector    pointer to a MSI(X) list address
+
+    @return  number of MSI(X) vectors
+**/
+uint32_t
+pal_get_msi_vectors(uint32_t Seg, uint32_t Bus, uint32_t Dev, uint32_t Fn, PERIPHERAL_VECTOR_LIST **MVector)
+{
+  (void) Seg;
+  (void) Bus;
+  (void) Dev;
+  (void) Fn;
+  (void) MVector;
+
+  return 0;
+}
+
+/**
+  @brief  Returns whether a PCIe Function is an on-chip peripheral or not
+
+  @param  bdf        - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return Returns TRUE if the Function is on-chip peripheral, FALSE if it is
+          not an on-chip peripheral
+**/
+uint32_t
+pal_pcie_is_onchip_peripheral(uint32_t bdf)
+{
+  (void) bdf;
+  return 0;
+}
+
+/**
+  @brief  Returns the memory offset that can be accesed safely.
+
+  @param  bdf      - PCIe BUS/Device/Function
+  @param  mem_type - If the memory is Pre-fetchable or Non-prefetchable memory
+  @return memory offset
+**/
+uint32_t
+pal_pcie_mem_get_offset(uint32_t bdf, PCIE_MEM_TYPE_INFO_e mem_type)
+{
+  (void) bdf;
+  (void) mem_type;
+  return MEM_OFFSET_SMALL;
+}
+
+/**
+  @brief  This API returns if the device is a exerciser. No exerciser is simulated.
+  @param  bdf - Bus/Device/Function
+  @return 1 - true 0 - false
+**/
+uint32_t
+pal_is_bdf_exerciser(uint32_t bdf)
+{
+  (void) bdf;
+  return 0;
+}
+
+/**
+  @brief   This API returns test specific data from the PCIe stimulus generation hardware
+  @param   Type         - data type for which the data needs to be returned
+  @param   Data         - test specific data to be be filled by pal layer
+  @param   Bdf          - Stimulus hardware BDF
+  @param   Ecam         - ECAM base of the stimulus hardware
+  @return  status       - 1 as no stimulus hardware is simulated
+**/
+uint32_t
+pal_exerciser_get_data(EXERCISER_DATA_TYPE Type, exerciser_data_t *Data, uint32_t Bdf, uint64_t Ecam)
+{
+  (void) Type;
+  (void) Data;
+  (void) Bdf;
+  (void) Ecam;
+  return 1;
+}
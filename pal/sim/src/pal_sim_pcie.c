@@ -0,0 +1,669 @@
+/** @file
+ * Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include "pal_pcie_enum.h"
+#include "pal_common_support.h"
+#include "platform_override_struct.h"
+#include "pal_sim.h"
+
+/* Simulated ECAM. The config space of every function in the snapshot is kept in memory
+   and served to pal_mmio_read/pal_mmio_write at the ECAM addresses it was captured at.
+   Functions missing from the snapshot read as all ones, as an unimplemented function does.
+
+   Snapshot records, one per line, anywhere in the line so that a raw ACS log can be used:
+     ACSE <segment> <start bus> <end bus> <ecam base>     ECAM region
+     ACSC <bdf> <offset> <dword0> <dword1> <dword2> <dword3>  16 bytes of config space
+     ACSM <bdf> <offset> <rw mask> <rw1c mask>              write masks of one register
+   ACSE and ACSC are printed by the VAL config space dump. ACSM records are optional and
+   replace the default masks, which cover the type 0/1 headers, the PCI Express capability
+   and AER. Bits outside the RW and RW1C masks are RO.
+*/
+
+#define SIM_CFG_DWORDS      (PCIE_CFG_SIZE / 4)
+#define SIM_FUNC_PER_BUS    (PCIE_MAX_DEV * PCIE_MAX_FUNC)
+#define SIM_BUS_SHIFT       20
+#define SIM_FUNC_SHIFT      12
+#define SIM_LINE_MAX        256
+#define SIM_MAX_CAP_WALK    48
+#define SIM_ECID_AER        0x0001
+
+/* Device/port types of the PCI Express capability which implement slot and root registers */
+#define SIM_DPT_RP          0x4
+#define SIM_DPT_DP          0x6
+#define SIM_DPT_RCEC        0xA
+
+typedef struct {
+  uint32_t cfg[SIM_CFG_DWORDS];
+  uint32_t rw[SIM_CFG_DWORDS];      /* Bits replaced by a write */
+  uint32_t rw1c[SIM_CFG_DWORDS];    /* Bits cleared by writing 1 */
+} SIM_PCIE_FUNC;
+
+typedef struct {
+  uint64_t      ecam_base;
+  uint32_t      segment;
+  uint32_t      start_bus;
+  uint32_t      end_bus;
+  SIM_PCIE_FUNC **func;             /* (bus - start_bus) * SIM_FUNC_PER_BUS + dev * 8 + func */
+} SIM_ECAM_REGION;
+
+/* Write masks of one register, offset relative to the start of its structure */
+typedef struct {
+  uint32_t offset;
+  uint32_t rw;
+  uint32_t rw1c;
+} SIM_REG_MASK;
+
+static const SIM_REG_MASK sim_type0_masks[] = {
+  {0x04, 0x00000547, 0xF9000000},   /* Command, Status */
+  {0x0C, 0x000000FF, 0x00000000},   /* Cache Line Size */
+  {0x3C, 0x000000FF, 0x00000000},   /* Interrupt Line */
+};
+
+static const SIM_REG_MASK sim_type1_masks[] = {
+  {0x04, 0x00000547, 0xF9000000},   /* Command, Status */
+  {0x0C, 0x000000FF, 0x00000000},   /* Cache Line Size */
+  {0x18, 0x00FFFFFF, 0x00000000},   /* Primary, Secondary and Subordinate Bus Number */
+  {0x1C, 0x0000F0F0, 0xF9000000},   /* I/O Base and Limit, Secondary Status */
+  {0x20, 0xFFF0FFF0, 0x00000000},   /* Memory Base and Limit */
+  {0x24, 0xFFF0FFF0, 0x00000000},   /* Prefetchable Memory Base and Limit */
+  {0x28, 0xFFFFFFFF, 0x00000000},   /* Prefetchable Base Upper 32 Bits */
+  {0x2C, 0xFFFFFFFF, 0x00000000},   /* Prefetchable Limit Upper 32 Bits */
+  {0x30, 0xFFFFFFFF, 0x00000000},   /* I/O Base and Limit Upper 16 Bits */
+  {0x3C, 0x005F00FF, 0x00000000},   /* Interrupt Line, Bridge Control */
+};
+
+static const SIM_REG_MASK sim_pcie_cap_masks[] = {
+  {0x08, 0x00007FFF, 0x000F0000},   /* Device Control, Device Status */
+  {0x10, 0x00000FFB, 0xC0000000},   /* Link Control, Link Status */
+  {0x28, 0x0000FFFF, 0x00000000},   /* Device Control 2 */
+  {0x30, 0x0000FFFF, 0x00000000},   /* Link Control 2 */
+};
+
+static const SIM_REG_MASK sim_pcie_port_masks[] = {
+  {0x18, 0x00001FFF, 0x011F0000},   /* Slot Control, Slot Status */
+  {0x1C, 0x0000001F, 0x00000000},   /* Root Control */
+  {0x20, 0x00000000, 0x00010000},   /* Root Status */
+};
+
+static const SIM_REG_MASK sim_aer_masks[] = {
+  {0x04, 0x00000000, 0xFFFFFFFF},   /* Uncorrectable Error Status */
+  {0x08, 0xFFFFFFFF, 0x00000000},   /* Uncorrectable Error Mask */
+  {0x0C, 0xFFFFFFFF, 0x00000000},   /* Uncorrectable Error Severity */
+  {0x10, 0x00000000, 0xFFFFFFFF},   /* Correctable Error Status */
+  {0x14, 0xFFFFFFFF, 0x00000000},   /* Correctable Error Mask */
+  {0x18, 0x00000540, 0x00000000},   /* Advanced Error Capabilities and Control */
+};
+
+static const SIM_REG_MASK sim_aer_root_masks[] = {
+  {0x2C, 0x00000007, 0x00000000},   /* Root Error Command */
+  {0x30, 0x00000000, 0x0000007F},   /* Root Error Status */
+};
+
+#define SIM_NUM_MASKS(table)   (sizeof(table) / sizeof(table[0]))
+
+static SIM_ECAM_REGION g_sim_ecam[PAL_SIM_MAX_ECAM];
+static uint32_t        g_sim_num_ecam;
+static uint32_t        g_sim_num_func;
+static uint64_t        g_sim_cfg_reads;
+static uint64_t        g_sim_cfg_writes;
+
+/* Platform tables read by the baremetal PCIe PAL, filled from the snapshot. The ECAM
+   regions and the device list are sized by initialising their last entry. No host
+   bridge is described, so pal_pcie_enumerate keeps the bus numbers and BARs captured. */
+PCIE_INFO_TABLE platform_pcie_cfg = {
+    .num_entries                                 = 0,
+    .block[PAL_SIM_MAX_ECAM - 1].ecam_base       = 0,
+};
+
+PCIE_ROOT_INFO_TABLE platform_root_pcie_cfg;
+
+PCIE_READ_TABLE platform_pcie_device_hierarchy = {
+    .num_entries                                 = 0,
+    .device[PAL_SIM_MAX_PCIE_DEV - 1].class_code = 0,
+};
+
+/**
+  @brief  Find the ECAM region decoding a bus of a segment.
+
+  @param  seg  PCIe segment
+  @param  bus  PCIe bus
+
+  @return Region, or NULL if no region decodes the bus
+**/
+static SIM_ECAM_REGION *
+pal_sim_find_region(uint32_t seg, uint32_t bus)
+{
+  uint32_t i;
+
+  for (i = 0; i < g_sim_num_ecam; i++) {
+      if ((g_sim_ecam[i].segment == seg) &&
+          (bus >= g_sim_ecam[i].start_bus) && (bus <= g_sim_ecam[i].end_bus))
+          return &g_sim_ecam[i];
+  }
+
+  return NULL;
+}
+
+/**
+  @brief  Look up the simulated function of a BDF.
+
+  @param  bdf     Segment/Bus/Dev/Func in PCIE_CREATE_BDF format
+  @param  create  1 to add the function if the snapshot did not describe it yet
+
+  @return Function, or NULL if it is not implemented
+**/
+static SIM_PCIE_FUNC *
+pal_sim_get_func(uint32_t bdf, uint32_t create)
+{
+  SIM_ECAM_REGION *region;
+  SIM_PCIE_FUNC   **slot;
+  uint32_t bus  = PCIE_EXTRACT_BDF_BUS(bdf);
+  uint32_t dev  = PCIE_EXTRACT_BDF_DEV(bdf);
+  uint32_t func = PCIE_EXTRACT_BDF_FUNC(bdf);
+
+  if ((dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC))
+      return NULL;
+
+  region = pal_sim_find_region(PCIE_EXTRACT_BDF_SEG(bdf), bus);
+  if (region == NULL)
+      return NULL;
+
+  slot = &region->func[(bus - region->start_bus) * SIM_FUNC_PER_BUS +
+                       dev * PCIE_MAX_FUNC + func];
+  if ((*slot == NULL) && create) {
+      *slot = calloc(1, sizeof(SIM_PCIE_FUNC));
+      if (*slot != NULL)
+          g_sim_num_func++;
+  }
+
+  return *slot;
+}
+
+/**
+  @brief  Apply a table of register write masks to a structure of a function.
+
+  @param  fn     Function
+  @param  base   Offset of the structure in the config space
+  @param  masks  Register masks, offsets relative to base
+  @param  num    Number of masks
+
+  @return None
+**/
+static void
+pal_sim_apply_masks(SIM_PCIE_FUNC *fn, uint32_t base, const SIM_REG_MASK *masks, uint32_t num)
+{
+  uint32_t i, index;
+
+  for (i = 0; i < num; i++) {
+      index = (base + masks[i].offset) / 4;
+      if (index >= SIM_CFG_DWORDS)
+          continue;
+
+      fn->rw[index]   = masks[i].rw;
+      fn->rw1c[index] = masks[i].rw1c;
+  }
+}
+
+/**
+  @brief  Make the address bits of the BARs and of the expansion ROM BAR writable.
+          The snapshot does not hold the BAR sizes, so each BAR is taken to be as large
+          as the alignment of its assigned address. A BAR left at 0 stays RO, as an
+          unimplemented BAR. ACSM records give the exact masks when sizing matters.
+
+  @param  fn          Function
+  @param  last_bar    Offset of the last BAR of the header type
+  @param  rom_offset  Offset of the expansion ROM BAR of the header type
+
+  @return None
+**/
+static void
+pal_sim_bar_masks(SIM_PCIE_FUNC *fn, uint32_t last_bar, uint32_t rom_offset)
+{
+  uint32_t offset, index;
+  uint32_t bar, addr_mask, addr;
+  uint32_t is_64bit;
+
+  for (offset = BAR0_OFFSET; offset <= last_bar; offset += 4) {
+      index = offset / 4;
+      bar = fn->cfg[index];
+      addr_mask = (bar & BAR_MIT_MASK) ? 0xFFFFFFFC : 0xFFFFFFF0;
+      is_64bit = !(bar & BAR_MIT_MASK) &&
+                 (((bar >> BAR_MDT_SHIFT) & BAR_MDT_MASK) == 0x2) && (offset < last_bar);
+      addr = bar & addr_mask;
+
+      if (addr)
+          fn->rw[index] = addr_mask & ~((addr & -addr) - 1);
+
+      if (is_64bit) {
+          offset += 4;
+          addr = fn->cfg[index + 1];
+          if (fn->rw[index])
+              fn->rw[index + 1] = 0xFFFFFFFF;
+          else if (addr)
+              fn->rw[index + 1] = ~((addr & -addr) - 1);
+      }
+  }
+
+  addr = fn->cfg[rom_offset / 4] & 0xFFFFF800;
+  if (addr)
+      fn->rw[rom_offset / 4] = (0xFFFFF800 & ~((addr & -addr) - 1)) | 0x1;
+}
+
+/**
+  @brief  Find a capability in the captured config space of a function.
+
+  @param  fn    Function
+  @param  cid   Capability ID
+  @param  ext   1 for an extended capability, 0 for a PCI capability
+
+  @return Offset of the capability, 0 if it is not present
+**/
+static uint32_t
+pal_sim_find_cap(SIM_PCIE_FUNC *fn, uint32_t cid, uint32_t ext)
+{
+  uint32_t ptr, hdr, count;
+
+  if (ext) {
+      for (ptr = PCIE_ECAP_START, count = 0; (ptr >= PCIE_ECAP_START) &&
+           (count < SIM_CFG_DWORDS); count++) {
+          hdr = fn->cfg[ptr / 4];
+          if ((hdr == 0) || (hdr == PCIE_UNKNOWN_RESPONSE))
+              break;
+          if ((hdr & PCIE_ECAP_CIDR_MASK) == cid)
+              return ptr;
+          ptr = (hdr >> PCIE_CAP_PTR_OFFSET) & PCIE_ECAP_NCPR_MASK & ~0x3;
+      }
+      return 0;
+  }
+
+  /* Status.Capabilities List */
+  if (!((fn->cfg[COMMAND_REG_OFFSET / 4] >> 16) & 0x10))
+      return 0;
+
+  ptr = fn->cfg[TYPE01_CPR / 4] & TYPE01_CPR_MASK & ~0x3;
+  for (count = 0; ptr && (count < SIM_MAX_CAP_WALK); count++) {
+      hdr = fn->cfg[ptr / 4];
+      if ((hdr & PCIE_CIDR_MASK) == cid)
+          return ptr;
+      ptr = (hdr >> PCI_CAP_PTR_OFFSET) & PCIE_NCPR_MASK & ~0x3;
+  }
+
+  return 0;
+}
+
+/**
+  @brief  Set the default write masks of a function from its captured config space.
+
+  @param  fn  Function
+
+  @return None
+**/
+static void
+pal_sim_default_masks(SIM_PCIE_FUNC *fn)
+{
+  uint32_t cap, dp_type;
+
+  if (PCIE_HEADER_TYPE(fn->cfg[HEADER_OFFSET / 4]) == TYPE1_HEADER) {
+      pal_sim_apply_masks(fn, 0, sim_type1_masks, SIM_NUM_MASKS(sim_type1_masks));
+      pal_sim_bar_masks(fn, TYPE1_BAR_MAX_OFF, 0x38);
+  } else {
+      pal_sim_apply_masks(fn, 0, sim_type0_masks, SIM_NUM_MASKS(sim_type0_masks));
+      pal_sim_bar_masks(fn, TYPE0_BAR_MAX_OFF, 0x30);
+  }
+
+  dp_type = 0;
+  cap = pal_sim_find_cap(fn, CID_PCIECS, 0);
+  if (cap) {
+      dp_type = (fn->cfg[cap / 4] >> (16 + PCIECR_DPT_SHIFT)) & PCIECR_DPT_MASK;
+      pal_sim_apply_masks(fn, cap, sim_pcie_cap_masks, SIM_NUM_MASKS(sim_pcie_cap_masks));
+      if ((dp_type == SIM_DPT_RP) || (dp_type == SIM_DPT_DP) || (dp_type == SIM_DPT_RCEC))
+          pal_sim_apply_masks(fn, cap, sim_pcie_port_masks, SIM_NUM_MASKS(sim_pcie_port_masks));
+  }
+
+  cap = pal_sim_find_cap(fn, SIM_ECID_AER, 1);
+  if (cap) {
+      pal_sim_apply_masks(fn, cap, sim_aer_masks, SIM_NUM_MASKS(sim_aer_masks));
+      if ((dp_type == SIM_DPT_RP) || (dp_type == SIM_DPT_RCEC))
+          pal_sim_apply_masks(fn, cap, sim_aer_root_masks, SIM_NUM_MASKS(sim_aer_root_masks));
+  }
+}
+
+/**
+  @brief  Describe the functions of the snapshot in platform_pcie_device_hierarchy, in
+          the order enumeration finds them. Host bridges and functions without the PCI
+          Express capability are left out, as VAL leaves them out of the BDF table.
+
+  @return None
+**/
+static void
+pal_sim_fill_device_hierarchy(void)
+{
+  SIM_ECAM_REGION *region;
+  SIM_PCIE_FUNC   *fn;
+  PCIE_READ_BLOCK *entry;
+  uint32_t i, index, num_index;
+  uint32_t class_code;
+
+  platform_pcie_device_hierarchy.num_entries = 0;
+
+  for (i = 0; i < g_sim_num_ecam; i++) {
+      region = &g_sim_ecam[i];
+      num_index = (region->end_bus - region->start_bus + 1) * SIM_FUNC_PER_BUS;
+
+      for (index = 0; index < num_index; index++) {
+          fn = region->func[index];
+          if ((fn == NULL) || ((fn->cfg[0] & 0xFFFF) == 0xFFFF))
+              continue;
+
+          class_code = fn->cfg[TYPE01_RIDR / 4];
+          if ((((class_code >> CC_BASE_SHIFT) & CC_BASE_MASK) == HB_BASE_CLASS) &&
+              (((class_code >> CC_SUB_SHIFT) & CC_SUB_MASK) == HB_SUB_CLASS))
+              continue;
+
+          if (!pal_sim_find_cap(fn, CID_PCIECS, 0))
+              continue;
+
+          if (platform_pcie_device_hierarchy.num_entries >= PAL_SIM_MAX_PCIE_DEV) {
+              print(ACS_PRINT_WARN, "\n PCIe snapshot has more than %d devices,"
+                    " the device list check will fail", PAL_SIM_MAX_PCIE_DEV);
+              return;
+          }
+
+          entry = &platform_pcie_device_hierarchy.device[
+                                              platform_pcie_device_hierarchy.num_entries++];
+          entry->class_code = class_code;
+          entry->vendor_id  = fn->cfg[0] & 0xFFFF;
+          entry->device_id  = fn->cfg[0] >> DEVICE_ID_OFFSET;
+          entry->seg        = region->segment;
+          entry->bus        = region->start_bus + index / SIM_FUNC_PER_BUS;
+          entry->dev        = (index % SIM_FUNC_PER_BUS) / PCIE_MAX_FUNC;
+          entry->func       = index % PCIE_MAX_FUNC;
+      }
+  }
+}
+
+/**
+  @brief  Release the simulated ECAM and the platform tables built from a snapshot.
+
+  @return None
+**/
+void
+pal_sim_pcie_free(void)
+{
+  uint32_t i, index, num_index;
+
+  for (i = 0; i < g_sim_num_ecam; i++) {
+      num_index = (g_sim_ecam[i].end_bus - g_sim_ecam[i].start_bus + 1) * SIM_FUNC_PER_BUS;
+      for (index = 0; index < num_index; index++)
+          free(g_sim_ecam[i].func[index]);
+      free(g_sim_ecam[i].func);
+  }
+
+  memset(g_sim_ecam, 0, sizeof(g_sim_ecam));
+  g_sim_num_ecam = 0;
+  g_sim_num_func = 0;
+  g_sim_cfg_reads = 0;
+  g_sim_cfg_writes = 0;
+  platform_pcie_cfg.num_entries = 0;
+  platform_pcie_device_hierarchy.num_entries = 0;
+}
+
+/**
+  @brief  Add an ECAM region of an ACSE record.
+
+  @param  rec  Record text starting at "ACSE"
+
+  @return None
+**/
+static void
+pal_sim_add_region(const char *rec)
+{
+  SIM_ECAM_REGION *region;
+  unsigned int seg, start_bus, end_bus;
+  unsigned long long ecam_base;
+  uint32_t i;
+
+  if (sscanf(rec, "ACSE %x %x %x %llx", &seg, &start_bus, &end_bus, &ecam_base) != 4)
+      return;
+
+  if ((end_bus < start_bus) || (end_bus >= PCIE_MAX_BUS)) {
+      print(ACS_PRINT_WARN, "\n Ignoring ECAM region with bus range %x", start_bus);
+      print(ACS_PRINT_WARN, " - %x", end_bus);
+      return;
+  }
+
+  /* A log holding the dump more than once repeats the regions */
+  for (i = 0; i < g_sim_num_ecam; i++) {
+      if ((g_sim_ecam[i].segment == seg) && (g_sim_ecam[i].start_bus == start_bus) &&
+          (g_sim_ecam[i].end_bus == end_bus))
+          return;
+  }
+
+  if (g_sim_num_ecam >= PAL_SIM_MAX_ECAM) {
+      print(ACS_PRINT_WARN, "\n More than %d ECAM regions in the snapshot", PAL_SIM_MAX_ECAM);
+      return;
+  }
+
+  region = &g_sim_ecam[g_sim_num_ecam];
+  region->func = calloc((end_bus - start_bus + 1) * SIM_FUNC_PER_BUS, sizeof(SIM_PCIE_FUNC *));
+  if (region->func == NULL) {
+      print(ACS_PRINT_ERR, "\n Simulated ECAM allocation failed", 0);
+      return;
+  }
+
+  region->ecam_base = ecam_base;
+  region->segment   = seg;
+  region->start_bus = start_bus;
+  region->end_bus   = end_bus;
+
+  platform_pcie_cfg.block[g_sim_num_ecam].ecam_base     = ecam_base;
+  platform_pcie_cfg.block[g_sim_num_ecam].segment_num   = seg;
+  platform_pcie_cfg.block[g_sim_num_ecam].start_bus_num = start_bus;
+  platform_pcie_cfg.block[g_sim_num_ecam].end_bus_num   = end_bus;
+  g_sim_num_ecam++;
+  platform_pcie_cfg.num_entries = g_sim_num_ecam;
+}
+
+/**
+  @brief  Load a config space snapshot into the simulated ECAM. Any snapshot loaded
+          before is released first. The file is read three times: ECAM regions, then
+          config space, then the ACSM mask records which override the default masks.
+
+  @param  path  Snapshot file, or an ACS log holding the config space dump
+
+  @return 0 on success, 1 if the file cannot be read or describes no ECAM region
+**/
+uint32_t
+pal_sim_pcie_load(const char *path)
+{
+  FILE          *fp;
+  SIM_PCIE_FUNC *fn;
+  char          line[SIM_LINE_MAX];
+  char          *rec;
+  unsigned int  bdf, offset, data[4], rw, rw1c;
+  uint32_t      i, index, num_index;
+
+  pal_sim_pcie_free();
+
+  fp = fopen(path, "r");
+  if (fp == NULL) {
+      print(ACS_PRINT_ERR, "\n Could not open PCIe snapshot %s", path);
+      return 1;
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+      rec = strstr(line, "ACSE");
+      if (rec != NULL)
+          pal_sim_add_region(rec);
+  }
+
+  if (g_sim_num_ecam == 0) {
+      print(ACS_PRINT_ERR, "\n No ECAM region in PCIe snapshot %s", path);
+      fclose(fp);
+      return 1;
+  }
+
+  rewind(fp);
+  while (fgets(line, sizeof(line), fp) != NULL) {
+      rec = strstr(line, "ACSC");
+      if ((rec == NULL) ||
+          (sscanf(rec, "ACSC %x %x %x %x %x %x", &bdf, &offset,
+                  &data[0], &data[1], &data[2], &data[3]) != 6))
+          continue;
+
+      if ((offset & 0xF) || (offset >= PCIE_CFG_SIZE))
+          continue;
+
+      fn = pal_sim_get_func(bdf, 1);
+      if (fn == NULL) {
+          print(ACS_PRINT_WARN, "\n BDF 0x%x of the snapshot is outside the ECAM regions", bdf);
+          continue;
+      }
+
+      for (i = 0; i < 4; i++)
+          fn->cfg[offset / 4 + i] = data[i];
+  }
+
+  for (i = 0; i < g_sim_num_ecam; i++) {
+      num_index = (g_sim_ecam[i].end_bus - g_sim_ecam[i].start_bus + 1) * SIM_FUNC_PER_BUS;
+      for (index = 0; index < num_index; index++) {
+          if (g_sim_ecam[i].func[index] != NULL)
+              pal_sim_default_masks(g_sim_ecam[i].func[index]);
+      }
+  }
+
+  rewind(fp);
+  while (fgets(line, sizeof(line), fp) != NULL) {
+      rec = strstr(line, "ACSM");
+      if ((rec == NULL) ||
+          (sscanf(rec, "ACSM %x %x %x %x", &bdf, &offset, &rw, &rw1c) != 4))
+          continue;
+
+      fn = pal_sim_get_func(bdf, 0);
+      if ((fn == NULL) || (offset >= PCIE_CFG_SIZE))
+          continue;
+
+      fn->rw[offset / 4]   = rw;
+      fn->rw1c[offset / 4] = rw1c;
+  }
+
+  fclose(fp);
+
+  pal_sim_fill_device_hierarchy();
+
+  print(ACS_PRINT_TEST, "\n PCIe snapshot: %d ECAM regions", g_sim_num_ecam);
+  print(ACS_PRINT_TEST, ", %d functions\n", g_sim_num_func);
+
+  return 0;
+}
+
+/**
+  @brief  Decode an address of the simulated ECAM.
+
+  @param  addr   Address
+  @param  fn     Function at the address, NULL if it is not implemented
+  @param  index  Config space dword at the address
+
+  @return 1 if the address is in a simulated ECAM region, else 0
+**/
+static uint32_t
+pal_sim_decode(uint64_t addr, SIM_PCIE_FUNC **fn, uint32_t *index)
+{
+  SIM_ECAM_REGION *region;
+  uint64_t start, end;
+  uint32_t i;
+
+  for (i = 0; i < g_sim_num_ecam; i++) {
+      region = &g_sim_ecam[i];
+      start = region->ecam_base + ((uint64_t)region->start_bus << SIM_BUS_SHIFT);
+      end = region->ecam_base + ((uint64_t)(region->end_bus + 1) << SIM_BUS_SHIFT);
+      if ((addr < start) || (addr >= end))
+          continue;
+
+      *fn = region->func[(addr - start) >> SIM_FUNC_SHIFT];
+      *index = (addr & (PCIE_CFG_SIZE - 1)) / 4;
+      return 1;
+  }
+
+  return 0;
+}
+
+/**
+  @brief  Read the simulated config space at an ECAM address. Unaligned reads return
+          the dword holding the address shifted down to the addressed byte.
+
+  @param  addr  ECAM address
+  @param  data  Value read
+
+  @return 1 if the address is in a simulated ECAM region, else 0
+**/
+uint32_t
+pal_sim_pcie_cfg_read(uint64_t addr, uint32_t *data)
+{
+  SIM_PCIE_FUNC *fn;
+  uint32_t      index;
+
+  if (!pal_sim_decode(addr, &fn, &index))
+      return 0;
+
+  g_sim_cfg_reads++;
+  *data = fn ? (fn->cfg[index] >> ((addr & 0x3) * 8)) : PCIE_UNKNOWN_RESPONSE;
+  return 1;
+}
+
+/**
+  @brief  Write the simulated config space at an ECAM address, honouring the RO, RW
+          and RW1C bits of the register. Writes to unimplemented functions are dropped.
+
+  @param  addr  ECAM address, dword aligned
+  @param  data  Value written
+
+  @return 1 if the address is in a simulated ECAM region, else 0
+**/
+uint32_t
+pal_sim_pcie_cfg_write(uint64_t addr, uint32_t data)
+{
+  SIM_PCIE_FUNC *fn;
+  uint32_t      index;
+  uint32_t      value;
+
+  if (!pal_sim_decode(addr, &fn, &index))
+      return 0;
+
+  g_sim_cfg_writes++;
+  if (fn == NULL)
+      return 1;
+
+  value = (fn->cfg[index] & ~fn->rw[index]) | (data & fn->rw[index]);
+  fn->cfg[index] = value & ~(data & fn->rw1c[index]);
+  return 1;
+}
+
+/**
+  @brief  Number of config space accesses served since the snapshot was loaded.
+
+  @param  cfg_reads   Config reads
+  @param  cfg_writes  Config writes
+
+  @return None
+**/
+void
+pal_sim_pcie_get_stats(uint64_t *cfg_reads, uint64_t *cfg_writes)
+{
+  *cfg_reads = g_sim_cfg_reads;
+  *cfg_writes = g_sim_cfg_writes;
+}
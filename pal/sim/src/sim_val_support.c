@@ -0,0 +1,141 @@
+/** @file
+ * Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/include/acs_val.h"
+#include "common/include/val_interface.h"
+#include "common/include/acs_memory.h"
+
+/* Host implementations of the VAL services used by the PCIe VAL code. The rest of
+   VAL runs on the PE and is not part of the simulated ECAM library. */
+
+extern uint32_t g_print_level;
+
+/**
+  @brief  Print a formatted string with one argument if level is at least g_print_level.
+
+  @param level   the print verbosity (1 to 5)
+  @param string  formatted ASCII string
+  @param data    64-bit data. set to 0 if no data is to sent to console.
+
+  @return        None
+ **/
+void
+val_print(uint32_t level, char8_t *string, uint64_t data)
+{
+  if (level < g_print_level)
+      return;
+
+  printf(string, data);
+}
+
+/**
+  @brief  Allocates requested buffer size in bytes.
+
+  @param  size  allocation size in bytes
+
+  @return pointer to allocated memory
+**/
+void *
+val_memory_alloc(uint32_t size)
+{
+  return malloc(size);
+}
+
+/**
+  @brief  Allocates a zeroed buffer of num elements of size bytes.
+
+  @param  num   number of elements
+  @param  size  element size in bytes
+
+  @return pointer to allocated memory
+**/
+void *
+val_memory_calloc(uint32_t num, uint32_t size)
+{
+  return calloc(num, size);
+}
+
+/**
+  @brief  Frees a buffer allocated by val_memory_alloc or val_memory_calloc.
+
+  @param  addr  buffer to free
+
+  @return None
+**/
+void
+val_memory_free(void *addr)
+{
+  free(addr);
+}
+
+/**
+  @brief  Sets a buffer to a value.
+
+  @param  buf    buffer to set
+  @param  size   number of bytes to set
+  @param  value  value of every byte
+
+  @return None
+**/
+void
+val_memory_set(void *buf, uint32_t size, uint8_t value)
+{
+  memset(buf, value, size);
+}
+
+/**
+  @brief  Copies a source buffer to a destination buffer.
+
+  @param  dst_buffer  destination of the copy
+  @param  src_buffer  source of the copy
+  @param  len         number of bytes to copy
+
+  @return dst_buffer
+**/
+void *
+val_memcpy(void *dst_buffer, void *src_buffer, uint32_t len)
+{
+  return memcpy(dst_buffer, src_buffer, len);
+}
+
+/**
+  @brief  Compares two strings
+
+  @param  str1  The pointer to a Null-terminated ASCII string.
+  @param  str2  The pointer to a Null-terminated ASCII string.
+  @param  len   The maximum number of ASCII characters for compare.
+
+  @return Zero if strings are identical, else non-zero value
+**/
+uint32_t
+val_strncmp(char8_t *str1, char8_t *str2, uint32_t len)
+{
+  return strncmp(str1, str2, len);
+}
+
+/**
+  @brief  Data synchronization barrier. The simulated ECAM is ordinary memory.
+
+  @return None
+**/
+void
+val_mem_issue_dsb(void)
+{
+}
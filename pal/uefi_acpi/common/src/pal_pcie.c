@@ -143,6 +143,31 @@ pal_pcie_create_info_table(PCIE_INFO_TABLE *PcieTable)
   return;
 }
 
+/**
+  @brief  Returns the number of ECAM regions described by the ACPI MCFG table
+
+  @param  None
+
+  @return  Number of ECAM regions, 0 if the MCFG table is not found
+**/
+UINT32
+pal_pcie_get_num_ecam(VOID)
+{
+
+  if (PLATFORM_OVERRIDE_PCIE_ECAM_BASE)
+      return 1;
+
+  gMcfgHdr = (EFI_ACPI_MEMORY_MAPPED_CONFIGURATION_BASE_ADDRESS_TABLE_HEADER *) pal_get_mcfg_ptr();
+
+  if ((gMcfgHdr == NULL) ||
+      (gMcfgHdr->Header.Length <= sizeof(EFI_ACPI_MEMORY_MAPPED_CONFIGURATION_BASE_ADDRESS_TABLE_HEADER)))
+      return 0;
+
+  return (gMcfgHdr->Header.Length -
+          sizeof(EFI_ACPI_MEMORY_MAPPED_CONFIGURATION_BASE_ADDRESS_TABLE_HEADER)) /
+          sizeof(EFI_ACPI_MEMORY_MAPPED_ENHANCED_CONFIGURATION_SPACE_BASE_ADDRESS_ALLOCATION_STRUCTURE);
+}
+
 /**
     @brief   Reads 32-bit data from PCIe config space pointed by Bus,
            Device, Function and register offset, using UEFI PciIoProtocol
@@ -54,19 +54,30 @@ incrementBusDev(UINT32 StartBdf)
   return PCIE_CREATE_BDF(Seg, Bus, Dev, 0);
 }
 
+/* One PciIo handle of the system, see palPcieCreateHandleIndex() */
+typedef struct {
+  EFI_PCI_IO_PROTOCOL *Pci;
+  UINT32              Bdf;
+  UINT8               BaseClass;
+  UINT8               SubClass;
+} PCIE_HANDLE_ENTRY;
+
+static PCIE_HANDLE_ENTRY *gPcieHandleIndex;
+static UINT32            gPcieHandleCount;
+
+/* Segment, bus and device of a BDF, the sort key of the handle index */
+#define PCIE_HANDLE_KEY(Bdf)  ((Bdf) & 0xFFFFFF00)
+
 /**
-    @brief   Returns the Bus, Dev, Function (in the form seg<<24 | bus<<16 | Dev <<8 | func)
-             for a matching class code.
+  @brief  Snapshot the PciIo handles with their location and class code, sorted by
+          segment, bus and device and in handle order within a device. Built on
+          first use and released by pal_pcie_free_info_table.
 
-    @param   ClassCode  - is a 32bit value of format ClassCode << 16 | sub_class_code
-    @param   StartBdf   - is 0     : start enumeration from Host bridge
-                          is not 0 : start enumeration from the input segment, bus, dev
-                          this is needed as multiple controllers with same class code are
-                          potentially present in a system.
-    @return  the BDF of the device matching the class code
+  @return EFI_SUCCESS if the index is available
 **/
-UINT32
-palPcieGetBdf(UINT32 ClassCode, UINT32 StartBdf)
+STATIC
+EFI_STATUS
+palPcieCreateHandleIndex(VOID)
 {
 
   EFI_STATUS                    Status;
@@ -74,56 +85,113 @@ palPcieGetBdf(UINT32 ClassCode, UINT32 StartBdf)
   UINTN                         HandleCount;
   EFI_HANDLE                    *HandleBuffer;
   UINTN                         Seg, Bus, Dev, Func;
-  UINT32                        Index;
-  PCI_TYPE_GENERIC              PciHeader;
-  PCI_DEVICE_INDEPENDENT_REGION *Hdr;
-  UINT32                        ThisBus, InputBus;
-  UINT32                        ThisDev, InputDev;
+  UINT32                        Index, Pos;
+  UINT32                        ClassReg;
+  PCIE_HANDLE_ENTRY             Entry;
 
+  if (gPcieHandleIndex != NULL)
+    return EFI_SUCCESS;
 
   Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiPciIoProtocolGuid, NULL, &HandleCount, &HandleBuffer);
   if (EFI_ERROR (Status)) {
     acs_print(ACS_PRINT_INFO,L" No PCI devices found in the system\n");
-    return EFI_SUCCESS;
+    return Status;
   }
 
-  InputBus = PCIE_EXTRACT_BDF_BUS(StartBdf);
-  InputDev = PCIE_EXTRACT_BDF_DEV(StartBdf);
-  /* Don't care about multi-function devices for now */
+  gPcieHandleIndex = pal_mem_alloc(HandleCount * sizeof(PCIE_HANDLE_ENTRY));
+  if (gPcieHandleIndex == NULL) {
+    pal_mem_free(HandleBuffer);
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  /* These loops are to search for devices in an incremental order of bus numbers, device numbers */
-  for (ThisBus = InputBus; ThisBus <= PCI_MAX_BUS; ThisBus++) {
-    for (ThisDev = InputDev; ThisDev <= PCI_MAX_DEVICE; ThisDev++) {
-      for (Index = 0; Index < HandleCount; Index++) {
-        Status = gBS->HandleProtocol (HandleBuffer[Index], &gEfiPciIoProtocolGuid, (VOID **)&Pci);
-        if (!EFI_ERROR (Status)) {
-          Pci->GetLocation (Pci, &Seg, &Bus, &Dev, &Func);
-          if (ThisBus != Bus) {
-            continue;
-          }
-          if (ThisDev != Dev) {
-            continue;
-          }
-          Status = Pci->Pci.Read (Pci, EfiPciIoWidthUint32, 0, sizeof (PciHeader)/sizeof (UINT32), &PciHeader);
-          if (!EFI_ERROR (Status)) {
-            Hdr = &PciHeader.Bridge.Hdr;
-            acs_print(ACS_PRINT_INFO,L"  %03d.%02d.%02d class_code = %d %d\n",
-                        Bus, Dev, Index, Hdr->ClassCode[1], Hdr->ClassCode[2]);
-            if (Hdr->ClassCode[2] == ((ClassCode >> 16) & 0xFF)) {
-              if (Hdr->ClassCode[1] == ((ClassCode >> 8) & 0xFF)) {
-                 /* Found our device */
-                 /* Return the BDF   */
-                 pal_mem_free(HandleBuffer);
-                 return (UINT32)(PCIE_CREATE_BDF(Seg, Bus, Dev, Func));
-              }
-            }
-          }
-        }
-      }
+  gPcieHandleCount = 0;
+  for (Index = 0; Index < HandleCount; Index++) {
+    Status = gBS->HandleProtocol (HandleBuffer[Index], &gEfiPciIoProtocolGuid, (VOID **)&Pci);
+    if (EFI_ERROR (Status))
+      continue;
+
+    Pci->GetLocation (Pci, &Seg, &Bus, &Dev, &Func);
+
+    /* Base class and sub class are bytes 0xB and 0xA of the config header */
+    Status = Pci->Pci.Read (Pci, EfiPciIoWidthUint32, PCI_REVISION_ID_OFFSET, 1, &ClassReg);
+    if (EFI_ERROR (Status))
+      continue;
+
+    Entry.Pci       = Pci;
+    Entry.Bdf       = (UINT32)(PCIE_CREATE_BDF(Seg, Bus, Dev, Func));
+    Entry.BaseClass = (ClassReg >> 24) & 0xFF;
+    Entry.SubClass  = (ClassReg >> 16) & 0xFF;
+    acs_print(ACS_PRINT_INFO,L"  %03d.%02d.%02d class_code = %d %d\n",
+                Bus, Dev, Index, Entry.SubClass, Entry.BaseClass);
+
+    /* Insertion sort on segment, bus and device, stable so that handle order is kept */
+    for (Pos = gPcieHandleCount; Pos > 0; Pos--) {
+      if (PCIE_HANDLE_KEY(gPcieHandleIndex[Pos - 1].Bdf) <= PCIE_HANDLE_KEY(Entry.Bdf))
+        break;
+      gPcieHandleIndex[Pos] = gPcieHandleIndex[Pos - 1];
     }
+    gPcieHandleIndex[Pos] = Entry;
+    gPcieHandleCount++;
   }
 
   pal_mem_free(HandleBuffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  @brief  Release the PAL state built while the PCIe info table is in use,
+          the PciIo handle index of palPcieGetBdf and palPcieGetBase.
+
+  @return None
+**/
+VOID
+pal_pcie_free_info_table(VOID)
+{
+  if (gPcieHandleIndex != NULL) {
+    pal_mem_free(gPcieHandleIndex);
+    gPcieHandleIndex = NULL;
+  }
+
+  gPcieHandleCount = 0;
+}
+
+/**
+    @brief   Returns the Bus, Dev, Function (in the form seg<<24 | bus<<16 | Dev <<8 | func)
+             for a matching class code.
+
+    @param   ClassCode  - is a 32bit value of format ClassCode << 16 | sub_class_code
+    @param   StartBdf   - is 0     : start enumeration from Host bridge
+                          is not 0 : start enumeration from the input segment, bus, dev
+                          this is needed as multiple controllers with same class code are
+                          potentially present in a system.
+    @return  the BDF of the device matching the class code
+**/
+UINT32
+palPcieGetBdf(UINT32 ClassCode, UINT32 StartBdf)
+{
+
+  UINT32                        Index;
+  UINT32                        Start;
+
+  if (EFI_ERROR (palPcieCreateHandleIndex()))
+    return 0;
+
+  /* Don't care about multi-function devices for now */
+  Start = PCIE_HANDLE_KEY(StartBdf);
+
+  /* The index is sorted by segment, bus and device, search from the input one onwards */
+  for (Index = 0; Index < gPcieHandleCount; Index++) {
+    if (PCIE_HANDLE_KEY(gPcieHandleIndex[Index].Bdf) < Start)
+      continue;
+
+    if ((gPcieHandleIndex[Index].BaseClass == ((ClassCode >> 16) & 0xFF)) &&
+        (gPcieHandleIndex[Index].SubClass == ((ClassCode >> 8) & 0xFF))) {
+      /* Found our device */
+      /* Return the BDF   */
+      return gPcieHandleIndex[Index].Bdf;
+    }
+  }
+
   return 0;
 }
 
@@ -161,52 +229,34 @@ palPcieGetBase(UINT32 bdf, UINT32 bar_index)
 
   EFI_STATUS                    Status;
   EFI_PCI_IO_PROTOCOL           *Pci;
-  UINTN                         HandleCount;
-  EFI_HANDLE                    *HandleBuffer;
-  UINTN                         Seg, Bus, Dev, Func;
   UINT32                        Index;
   PCI_TYPE_GENERIC              PciHeader;
   PCI_DEVICE_HEADER_TYPE_REGION *Device;
-  UINT32                        InputSeg, InputBus, InputDev, InputFunc;
   UINT64                        bar_value;
 
-  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiPciIoProtocolGuid, NULL, &HandleCount, &HandleBuffer);
-  if (EFI_ERROR (Status)) {
-    acs_print(ACS_PRINT_INFO,L" No PCI devices found in the system\n");
-    return EFI_SUCCESS;
-  }
+  if (EFI_ERROR (palPcieCreateHandleIndex()))
+    return 0;
 
-  InputSeg = (bdf >> 24) & 0xFF;
-  InputBus = (bdf >> 16) & 0xFF;
-  InputDev = (bdf >> 8)  & 0xFF;
-  InputFunc = bdf & 0xFF;
+  for (Index = 0; Index < gPcieHandleCount; Index++) {
+    if (gPcieHandleIndex[Index].Bdf != bdf)
+      continue;
 
-  for (Index = 0; Index < HandleCount; Index++) {
-    Status = gBS->HandleProtocol (HandleBuffer[Index], &gEfiPciIoProtocolGuid, (VOID **)&Pci);
+    Pci = gPcieHandleIndex[Index].Pci;
+    Status = Pci->Pci.Read (Pci, EfiPciIoWidthUint32, 0, sizeof (PciHeader)/sizeof (UINT32), &PciHeader);
     if (!EFI_ERROR (Status)) {
-      Pci->GetLocation (Pci, &Seg, &Bus, &Dev, &Func);
-
-      if ((Seg == InputSeg) && (Bus == InputBus) && (Dev == InputDev) && (Func == InputFunc)) {
-          Status = Pci->Pci.Read (Pci, EfiPciIoWidthUint32, 0, sizeof (PciHeader)/sizeof (UINT32), &PciHeader);
-          if (!EFI_ERROR (Status)) {
-            Device = &PciHeader.Device.Device;
-            pal_mem_free(HandleBuffer);
-            if ((((Device->Bar[bar_index]) >> BAR_MDT_SHIFT) & BAR_MDT_MASK) == BITS_64)
-            {
-                bar_value = Device->Bar[bar_index + 1];
-                bar_value = (bar_value << 32) | (Device->Bar[bar_index]);
-                return bar_value;
-            }
-
-            else
-                return (Device->Bar[bar_index]);
-        }
+      Device = &PciHeader.Device.Device;
+      if ((((Device->Bar[bar_index]) >> BAR_MDT_SHIFT) & BAR_MDT_MASK) == BITS_64)
+      {
+          bar_value = Device->Bar[bar_index + 1];
+          bar_value = (bar_value << 32) | (Device->Bar[bar_index]);
+          return bar_value;
       }
 
+      else
+          return (Device->Bar[bar_index]);
     }
   }
 
-  pal_mem_free(HandleBuffer);
   return 0;
 }
 
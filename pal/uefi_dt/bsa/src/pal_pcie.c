@@ -146,6 +146,48 @@ pal_pcie_create_info_table(PCIE_INFO_TABLE *PcieTable)
   return;
 }
 
+/**
+  @brief  Release the PAL state built while the PCIe info table is in use.
+          The info table is read from the device tree, nothing to release.
+
+  @return  None
+ **/
+VOID
+pal_pcie_free_info_table(VOID)
+{
+}
+
+/**
+  @brief  Returns the number of ECAM regions, counted from the PCIe host
+          bridge nodes of the DT blob.
+
+  @param  None
+
+  @return  Number of ECAM regions, 0 if the DT blob is not found
+**/
+UINT32
+pal_pcie_get_num_ecam(VOID)
+{
+  UINT64 dt_ptr;
+  UINT32 num_ecam = 0;
+  UINT32 i;
+  int offset;
+
+  dt_ptr = pal_get_dt_ptr();
+  if (dt_ptr == 0)
+    return 0;
+
+  for (i = 0; i < sizeof(pci_dt_arr)/PCI_COMPATIBLE_STR_LEN ; i++) {
+      offset = fdt_node_offset_by_compatible((const void *)dt_ptr, -1, pci_dt_arr[i]);
+      while (offset >= 0) {
+          num_ecam++;
+          offset = fdt_node_offset_by_compatible((const void *)dt_ptr, offset, pci_dt_arr[i]);
+      }
+  }
+
+  return num_ecam;
+}
+
 /**
     @brief   Reads 32-bit data from PCIe config space pointed by Bus,
            Device, Function and register offset, using UEFI PciIoProtocol
@@ -98,6 +98,7 @@ create_va_pa_mapping (uint64_t txn_va, uint64_t txn_pa,
 {
   smmu_master_attributes_t master;
   memory_region_descriptor_t mem_desc_array[2], *mem_desc;
+  pgt_ctx_t pgt_ctx;
   uint32_t e_bdf = val_exerciser_get_bdf(req_instance);
   uint64_t ttbr;
   uint32_t num_smmus;
@@ -111,6 +112,7 @@ create_va_pa_mapping (uint64_t txn_va, uint64_t txn_pa,
 
   val_memory_set(&master, sizeof(master), 0);
   val_memory_set(mem_desc_array, sizeof(mem_desc_array), 0);
+  val_memory_set(&pgt_ctx, sizeof(pgt_ctx), 0);
   mem_desc = &mem_desc_array[0];
 
   /* Get translation attributes via TCR and translation table base via TTBR */
@@ -166,10 +168,10 @@ create_va_pa_mapping (uint64_t txn_va, uint64_t txn_pa,
       if (!pgt_desc->oas)
         goto test_fail;
 
-      /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create
+      /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_ctx_create
        will update pgt_desc.pgt_base to point to created translation table */
       pgt_desc->pgt_base = (uint64_t) NULL;
-      if (val_pgt_create(mem_desc, pgt_desc))
+      if (val_pgt_ctx_create(&pgt_ctx, mem_desc, pgt_desc))
         goto test_fail;
 
       /* Configure SMMU tables for this exerciser to use this page table for VA to PA translations*/
@@ -230,7 +232,7 @@ test_fail:
       status = ACS_STATUS_FAIL;
 
 test_clean:
-      val_pgt_destroy(*pgt_desc);
+      val_pgt_ctx_free(&pgt_ctx);
       val_smmu_unmap(master);
 
   return status;
@@ -142,6 +142,7 @@ payload(void)
           val_pcie_read_cfg(bdf, cap_base + DCTLR_OFFSET, &reg_value);
           reg_value = reg_value | DCTLR_FLR_SET;
           val_pcie_write_cfg(bdf, cap_base + DCTLR_OFFSET, reg_value);
+          val_pcie_cap_dir_invalidate(bdf);
 
           /* Wait for 100 ms */
           status = val_time_delay_ms(100 * ONE_MILLISECOND);
@@ -45,6 +45,11 @@ set(ASM_COMPILE_DEBUG_OPTIONS "-g -Wa,--gdwarf-4")
 add_definitions(-DTARGET_EMULATION)
 add_definitions(-DTARGET_BM_BOOT)
 
+# Per test phase timing and the end of run profile report
+if(ACS_PROFILE)
+    add_definitions(-DACS_PROFILE)
+endif()
+
 if(ACS MATCHES "sbsa")
     add_definitions(-DSBSA)
 elseif(ACS MATCHES "bsa")
@@ -0,0 +1,146 @@
+## @file
+ # Copyright (c) 2025, Arm Limited or its affiliates. All rights reserved.
+ # SPDX-License-Identifier : Apache-2.0
+ #
+ # Licensed under the Apache License, Version 2.0 (the "License");
+ # you may not use this file except in compliance with the License.
+ # You may obtain a copy of the License at
+ #
+ #  http://www.apache.org/licenses/LICENSE-2.0
+ #
+ # Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ ##
+
+# Convert the structured result records of an ACS log (-results option) to JUnit XML.
+#
+#   ACSH <counter frequency in hex>
+#   ACSR <word in hex> <elapsed counter ticks in hex> <rule id>
+#
+# word packs the test number [63:48], the reporting PE index [47:32]
+# and the 32-bit status word of that PE [31:0].
+#
+# Usage: python3 acs_results_junit.py <acs log> [<junit xml>]
+
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+STATE_BIT   = 28
+STATE_MASK  = 0xF
+STATUS_MASK = 0xFFF
+
+TEST_PASS_VAL = 0x4
+TEST_FAIL_VAL = 0x8
+TEST_SKIP_VAL = 0x9
+
+# Test number base of each module, see val/common/include/acs_common.h
+MODULES = [
+    (1400, 'ete'),
+    (1300, 'nist'),
+    (1200, 'ras'),
+    (1100, 'pmu'),
+    (1000, 'mpam'),
+    (900,  'exerciser'),
+    (800,  'pcie'),
+    (700,  'watchdog'),
+    (600,  'peripheral'),
+    (500,  'wakeup'),
+    (400,  'timer'),
+    (300,  'smmu'),
+    (200,  'gic'),
+    (100,  'memory_map'),
+    (0,    'pe'),
+]
+
+HEADER = re.compile(r'ACSH ([0-9a-fA-F]+)')
+RECORD = re.compile(r'ACSR ([0-9a-fA-F]+) ([0-9a-fA-F]+) (.*)')
+
+def module_name(test_num):
+    for base, name in MODULES:
+        if test_num >= base:
+            return name
+    return 'unknown'
+
+def parse_log(log_file):
+    freq = 0
+    records = []
+
+    with open(log_file, 'r', errors='replace') as log:
+        for line in log:
+            match = HEADER.search(line)
+            if match:
+                freq = int(match.group(1), 16)
+                continue
+            match = RECORD.search(line)
+            if match:
+                word = int(match.group(1), 16)
+                records.append({
+                    'test_num': (word >> 48) & 0xFFFF,
+                    'pe':       (word >> 32) & 0xFFFF,
+                    'status':   word & 0xFFFFFFFF,
+                    'ticks':    int(match.group(2), 16),
+                    'rule':     match.group(3).strip(),
+                })
+
+    return freq, records
+
+def to_junit(freq, records):
+    suites = ET.Element('testsuites')
+    by_module = {}
+
+    for rec in records:
+        by_module.setdefault(module_name(rec['test_num']), []).append(rec)
+
+    for name, recs in by_module.items():
+        suite = ET.SubElement(suites, 'testsuite', name=name)
+        failures = skipped = 0
+        total_time = 0.0
+
+        for rec in recs:
+            state = (rec['status'] >> STATE_BIT) & STATE_MASK
+            checkpoint = rec['status'] & STATUS_MASK
+            elapsed = (rec['ticks'] / freq) if freq else 0.0
+            total_time += elapsed
+
+            case = ET.SubElement(suite, 'testcase', classname=name,
+                                 name='%d : %s' % (rec['test_num'], rec['rule']),
+                                 time='%.6f' % elapsed)
+            if state == TEST_FAIL_VAL:
+                failures += 1
+                ET.SubElement(case, 'failure',
+                              message='Failed on PE %d, checkpoint %d' % (rec['pe'], checkpoint))
+            elif state == TEST_SKIP_VAL:
+                skipped += 1
+                ET.SubElement(case, 'skipped',
+                              message='Skipped on PE %d, checkpoint %d' % (rec['pe'], checkpoint))
+            elif state != TEST_PASS_VAL:
+                failures += 1
+                ET.SubElement(case, 'failure',
+                              message='Unexpected status 0x%x on PE %d' % (rec['status'], rec['pe']))
+
+        suite.set('tests', str(len(recs)))
+        suite.set('failures', str(failures))
+        suite.set('skipped', str(skipped))
+        suite.set('time', '%.6f' % total_time)
+
+    return ET.ElementTree(suites)
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Usage: python3 acs_results_junit.py <acs log> [<junit xml>]")
+        sys.exit(1)
+
+    freq, records = parse_log(sys.argv[1])
+    if not records:
+        print("No ACSR records found, was the log captured with -results?")
+        sys.exit(1)
+
+    tree = to_junit(freq, records)
+    if len(sys.argv) > 2:
+        tree.write(sys.argv[2], encoding='utf-8', xml_declaration=True)
+    else:
+        tree.write(sys.stdout, encoding='unicode')
@@ -54,7 +54,7 @@
                                        /*[(268+32*5) B Each + 24 B Header]*/
 #define PERIPHERAL_INFO_TBL_SZ  2048   /*Supports max 20 PCIe EPs (USB and SATA controllers)*/
                                        /*[72 B Each + 16 B Header]*/
-#define PCIE_INFO_TBL_SZ        1024   /*Supports max 40 RC's    */
+#define PCIE_INFO_TBL_SZ        1024   /*Supports max 40 RC's, grown from MCFG*/
                                        /*[24 B Each + 4 B Header]*/
 #define SMBIOS_INFO_TBL_SZ      1024   /*Supports max 16 Processor Slots/Sockets*/
                                        /*[64 B Each]*/
@@ -58,6 +58,15 @@ UINT32  g_num_modules = 0;
    of EL1 phy and virt timer, Below command line option is added only for debug
    purpose to complete BSA run on these systems */
 UINT32  g_el1physkip = FALSE;
+/* Keep secondary PEs parked in the VAL worker pool instead of PSCI CPU_ON/CPU_OFF per payload */
+UINT32  g_pe_pool = FALSE;
+/* Queue val_print output in per PE rings and drain it at test boundaries */
+UINT32  g_log_buffer = FALSE;
+/* Emit a structured ACSR record per test verdict alongside the text report */
+UINT32  g_result_stream = FALSE;
+/* Find PCIe functions by walking bridge bus ranges instead of probing every bus */
+UINT32  g_pcie_enum_topology = FALSE;
+UINT32  g_pcie_cfg_dump = FALSE;
 
 SHELL_FILE_HANDLE g_acs_log_file_handle;
 SHELL_FILE_HANDLE g_dtb_log_file_handle;
@@ -139,6 +148,25 @@ createWatchdogInfoTable(
 }
 
 
+/**
+  @brief  Size of the PCIe info table, PCIE_INFO_TBL_SZ unless the platform
+          describes more ECAM regions than that holds.
+**/
+UINT32
+getPcieInfoTableSize(
+)
+{
+  UINT32 NumEcam;
+  UINT32 Size;
+
+  NumEcam = val_pcie_get_num_ecam();
+
+  /* Keep the table size 16 Bytes aligned */
+  Size = (sizeof(PCIE_INFO_TABLE) + NumEcam * sizeof(PCIE_INFO_BLOCK) + 15) & ~15;
+
+  return (Size > PCIE_INFO_TBL_SZ) ? Size : PCIE_INFO_TBL_SZ;
+}
+
 VOID
 createPcieVirtInfoTable(
 )
@@ -146,7 +174,7 @@ createPcieVirtInfoTable(
   UINT64 *PcieInfoTable;
   UINT64 *IoVirtInfoTable;
 
-  PcieInfoTable   = val_aligned_alloc(SIZE_4K, PCIE_INFO_TBL_SZ);
+  PcieInfoTable   = val_aligned_alloc(SIZE_4K, getPcieInfoTableSize());
 
   val_pcie_create_info_table(PcieInfoTable);
 
@@ -185,6 +213,8 @@ createSmbiosInfoTable(
 VOID
 freeBsaAcsMem()
 {
+  /* Drains the print rings and powers off the PE pool, needs the PE info table */
+  val_free_shared_mem();
   val_pe_free_info_table();
   val_gic_free_info_table();
   val_timer_free_info_table();
@@ -193,7 +223,6 @@ freeBsaAcsMem()
   val_iovirt_free_info_table();
   val_peripheral_free_info_table();
   val_smbios_free_info_table();
-  val_free_shared_mem();
 }
 
 VOID
@@ -235,6 +264,12 @@ HelpMsg (
          "-dtb    Enable the execution of dtb dump\n"
          "-sbsa   Enable sbsa requirements for bsa binary\n"
          "-el1physkip Skips EL1 register checks\n"
+         "-pe_pool  Keep secondary PEs resident in a dispatch loop instead of\n"
+         "          powering them on and off for every multi-PE payload\n"
+         "-logbuf   Buffer prints in per PE rings and write them out at test boundaries\n"
+         "-results  Emit a structured result record per test, see acs_results_junit.py\n"
+         "-pcie_topo  Enumerate PCIe through bridge bus ranges instead of probing every bus\n"
+         "-pcie_dump  Dump the config space of every PCIe function found, for replay, use with -v 1\n"
   );
 }
 
@@ -260,6 +295,11 @@ STATIC CONST SHELL_PARAM_ITEM ParamList[] = {
   {L"-no_crypto_ext", TypeFlag},  // -no_crypto_ext  # Skip tests which have export restrictions
   {L"-mmio", TypeFlag}, // -mmio # Enable pal_mmio prints
   {L"-el1physkip", TypeFlag}, // -el1physkip # Skips EL1 register checks
+  {L"-pe_pool", TypeFlag}, // -pe_pool # Keep secondary PEs resident between payloads
+  {L"-logbuf", TypeFlag},  // -logbuf  # Buffer prints and drain them at test boundaries
+  {L"-results", TypeFlag}, // -results # Emit structured result records
+  {L"-pcie_topo", TypeFlag}, // -pcie_topo # Topology based PCIe enumeration
+  {L"-pcie_dump", TypeFlag}, // -pcie_dump # Dump PCIe config space snapshot
   {NULL, TypeMax}
   };
 
@@ -553,6 +593,26 @@ ShellAppMain (
   if (ShellCommandLineGetFlag (ParamPackage, L"-el1physkip")) {
     g_el1physkip = TRUE;
   }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-pe_pool")) {
+    g_pe_pool = TRUE;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-logbuf")) {
+    g_log_buffer = TRUE;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-results")) {
+    g_result_stream = TRUE;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-pcie_topo")) {
+    g_pcie_enum_topology = TRUE;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-pcie_dump")) {
+    g_pcie_cfg_dump = TRUE;
+  }
   //
   // Initialize global counters
   //
@@ -598,12 +658,28 @@ ShellAppMain (
 
   createTimerInfoTable();
   createWatchdogInfoTable();
+
+  if (g_pcie_enum_topology)
+      val_pcie_set_enum_mode(PCIE_ENUM_TOPOLOGY);
+
+  if (g_pcie_cfg_dump)
+      val_pcie_set_cfg_dump(1);
+
   createPcieVirtInfoTable();
   createPeripheralInfoTable();
   createSmbiosInfoTable();
 
   val_allocate_shared_mem();
 
+  if (g_pe_pool)
+      val_pe_pool_enable(1);
+
+  if (g_log_buffer)
+      val_print_buffer_enable(1);
+
+  if (g_result_stream)
+      val_result_stream_enable(1);
+
   FlushImage();
 
   /***  Starting PE tests             ***/
@@ -643,6 +719,8 @@ print_test_status:
   val_print(ACS_PRINT_ERR, "  Tests Failed = %4d\n", g_acs_tests_fail);
   val_print(ACS_PRINT_ERR, "     -------------------------------------------------------\n", 0);
 
+  val_profile_report();
+
   freeBsaAcsMem();
 
   if (g_dtb_log_file_handle) {
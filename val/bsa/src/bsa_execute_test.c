@@ -667,7 +667,7 @@ val_bsa_memory_execute_tests(uint32_t num_pe, uint32_t *g_sw_view)
 uint32_t
 val_bsa_wakeup_execute_tests(uint32_t num_pe, uint32_t *g_sw_view)
 {
-  uint32_t status, i;
+  uint32_t status, i, pe_pool;
 
   if (!(g_bsa_level >= 1 || g_bsa_only_level == 1))
       return ACS_STATUS_SKIP;
@@ -689,6 +689,9 @@ val_bsa_wakeup_execute_tests(uint32_t num_pe, uint32_t *g_sw_view)
   val_print_test_start("Wakeup semantic");
   status = ACS_STATUS_PASS;
 
+  /* Wakeup tests rely on secondary PEs being powered off between payloads */
+  pe_pool = val_pe_pool_enable(0);
+
   g_curr_module = 1 << WAKEUP_MODULE;
 
   if (g_sw_view[G_SW_OS]) {
@@ -713,6 +716,8 @@ if (g_build_sbsa) {
   view_print_info(MODULE_END);
   val_print_test_end(status, "Wakeup");
 
+  val_pe_pool_enable(pe_pool);
+
   return status;
 
 }
@@ -37,6 +37,12 @@ void val_memory_free_pages(void *page_base, uint32_t num_pages);
 void *val_aligned_alloc(uint32_t alignment, uint32_t size);
 void val_memory_free_aligned(void *addr);
 uint32_t val_memory_region_has_52bit_addr(void);
+#ifdef TARGET_BM_BOOT
+uint32_t val_memory_arena_checkpoint(void);
+uint64_t val_memory_arena_release(uint32_t checkpoint);
+void val_memory_heap_stats(uint64_t *live, uint64_t *peak);
+#endif
+void val_memory_arena_keep(void *addr);
 
 void AA64IssueDSB(void);
 void val_mem_issue_dsb(void);
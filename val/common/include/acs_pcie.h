@@ -73,8 +73,10 @@
 #define BAR_MASK           0xFFFFFFF0
 #define MSI_BIR_MASK       0xFFFFFFF8
 
-/* Allows storage of 2048 valid BDFs */
+/* Initial size of the BDF table, allows storage of 1023 valid BDFs before it grows */
 #define PCIE_DEVICE_BDF_TABLE_SZ 8192
+#define PCIE_BDF_TABLE_ENTRIES(size) \
+        (((size) - sizeof(pcie_device_bdf_table)) / sizeof(pcie_device_attr))
 
 typedef enum {
   HEADER = 0,
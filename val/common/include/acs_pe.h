@@ -403,6 +403,12 @@ uint64_t AA64ReadTrcidr5(void);
 
 void ArmCallWFI(void);
 
+void ArmCallWFE(void);
+
+void ArmCallSEV(void);
+
+void ArmCallWFET(uint64_t timeout_ticks);
+
 void ArmExecuteMemoryBarrier(void);
 
 void val_pe_update_elr(void *context, uint64_t offset);
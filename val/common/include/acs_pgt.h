@@ -62,8 +62,29 @@
 #define PAGE_SIZE_16K       (4 * 0x1000)
 #define PAGE_SIZE_64K       (16 * 0x1000)
 
+/* Page table builder state, see val_pgt_ctx_create */
+typedef struct {
+    uint32_t page_size;
+    uint32_t page_size_log2;
+    uint32_t bits_per_level;
+    uint64_t addr_mask;      /* Output address bits of a table descriptor */
+    void     *pool;          /* Contiguous table page pool, NULL to allocate pages one at a time */
+    uint32_t pool_pages;
+    uint32_t pages_used;     /* Table pages used, or needed when dry_run is set */
+    uint32_t dry_run;
+    memory_region_descriptor_t *regions;  /* Region array of the walk, for dry run sizing */
+} pgt_ctx_t;
+
 uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc);
+uint32_t val_pgt_ctx_create(pgt_ctx_t *ctx, memory_region_descriptor_t *mem_desc,
+                            pgt_descriptor_t *pgt_desc);
+void val_pgt_ctx_free(pgt_ctx_t *ctx);
 void val_pgt_destroy(pgt_descriptor_t pgt_desc);
 uint64_t val_pgt_get_attributes(pgt_descriptor_t pgt_desc, uint64_t virtual_address, uint64_t *attributes);
+uint32_t val_pgt_walk(uint64_t root, uint32_t ias, uint32_t page_size_log2,
+                      uint64_t virtual_address, uint64_t *desc, uint32_t *level);
+void val_pgt_walk_cache_create(uint32_t num_pe);
+void val_pgt_walk_cache_free(void);
+void val_pgt_walk_cache_invalidate(void);
 
 #endif
@@ -24,10 +24,27 @@
 #include "acs_common.h"
 
 
+/* Worker pool mailbox states, see val_pe_pool_enable() */
+#define VAL_PE_POOL_OFF      0x0   /* PE powers off after its payload (legacy CPU_ON flow) */
+#define VAL_PE_POOL_PARK     0x1   /* PE parks in the dispatch loop after its payload */
+#define VAL_PE_POOL_IDLE     0x2   /* PE is parked and waiting for a payload */
+#define VAL_PE_POOL_RUN      0x3   /* Payload posted in data0/data1, PE to run it */
+#define VAL_PE_POOL_EXIT     0x4   /* PE to leave the dispatch loop and power off */
+
+/* Per PE print ring depth and the primary PE drain threshold, see val_print_buffer_enable() */
+#define VAL_PRINT_RING_ENTRIES     128
+#define VAL_PRINT_RING_HIGH_WATER  96
+/* Largest cache writeback granule the print rings are laid out for */
+#define VAL_PRINT_RING_LINE        256
+
 typedef struct {
   uint64_t    data0;
   uint64_t    data1;
   uint32_t    status;
+  uint32_t    pool_state;
+#ifdef ACS_PROFILE
+  uint64_t    payload_ticks;  /* counter ticks of the last payload run by this PE */
+#endif
 }VAL_SHARED_MEM_t;
 
 uint64_t
@@ -57,5 +74,14 @@ val_set_status(uint32_t index, uint32_t status);
 uint32_t
 val_get_status(uint32_t id);
 
+volatile VAL_SHARED_MEM_t *
+val_get_shared_mem_entry(uint32_t index);
+
+void
+val_set_pool_state(uint32_t index, uint32_t state);
+
+uint32_t
+val_get_pool_state(uint32_t index);
+
 #endif
 
@@ -62,6 +62,10 @@
 #define TIMEOUT_LARGE    0x1000000
 #define TIMEOUT_MEDIUM   0x100000
 #define TIMEOUT_SMALL    0x1000
+/* Timeouts in microseconds for waits bounded by the generic counter */
+#define TIMEOUT_US_LARGE     10000000
+#define TIMEOUT_US_MEDIUM    1000000
+#define TIMEOUT_US_SMALL     1000
 
 #define PCIE_MAX_BUS   256
 #define PCIE_MAX_DEV    32
@@ -84,6 +88,10 @@
 #define TIMEOUT_LARGE    PLATFORM_BM_OVERRIDE_TIMEOUT_LARGE
 #define TIMEOUT_MEDIUM   PLATFORM_BM_OVERRIDE_TIMEOUT_MEDIUM
 #define TIMEOUT_SMALL    PLATFORM_BM_OVERRIDE_TIMEOUT_SMALL
+/* Timeouts in microseconds for waits bounded by the generic counter */
+#define TIMEOUT_US_LARGE     PLATFORM_BM_OVERRIDE_TIMEOUT_US_LARGE
+#define TIMEOUT_US_MEDIUM    PLATFORM_BM_OVERRIDE_TIMEOUT_US_MEDIUM
+#define TIMEOUT_US_SMALL     PLATFORM_BM_OVERRIDE_TIMEOUT_US_SMALL
 
 #define PCIE_MAX_BUS     PLATFORM_BM_OVERRIDE_PCIE_MAX_BUS
 #define PCIE_MAX_DEV     PLATFORM_BM_OVERRIDE_PCIE_MAX_DEV
@@ -109,6 +117,10 @@
 #define TIMEOUT_LARGE    PLATFORM_BM_OVERRIDE_TIMEOUT_LARGE
 #define TIMEOUT_MEDIUM   PLATFORM_BM_OVERRIDE_TIMEOUT_MEDIUM
 #define TIMEOUT_SMALL    PLATFORM_BM_OVERRIDE_TIMEOUT_SMALL
+/* Timeouts in microseconds for waits bounded by the generic counter */
+#define TIMEOUT_US_LARGE     PLATFORM_BM_OVERRIDE_TIMEOUT_US_LARGE
+#define TIMEOUT_US_MEDIUM    PLATFORM_BM_OVERRIDE_TIMEOUT_US_MEDIUM
+#define TIMEOUT_US_SMALL     PLATFORM_BM_OVERRIDE_TIMEOUT_US_SMALL
 
 #define PCIE_MAX_BUS    PLATFORM_BM_OVERRIDE_PCIE_MAX_BUS
 #define PCIE_MAX_DEV    PLATFORM_BM_OVERRIDE_PCIE_MAX_DEV
@@ -146,6 +158,18 @@
     #define TIMEOUT_SMALL    0x1000
 #endif
 
+/* Timeouts in microseconds for waits bounded by the generic counter. Unlike the
+   TIMEOUT_* loop counts these do not depend on core frequency or cache behaviour */
+#if PLATFORM_OVERRIDE_TIMEOUT_US
+    #define TIMEOUT_US_LARGE     PLATFORM_OVERRIDE_TIMEOUT_US_LARGE
+    #define TIMEOUT_US_MEDIUM    PLATFORM_OVERRIDE_TIMEOUT_US_MEDIUM
+    #define TIMEOUT_US_SMALL     PLATFORM_OVERRIDE_TIMEOUT_US_SMALL
+#else
+    #define TIMEOUT_US_LARGE     10000000  /* 10 s   */
+    #define TIMEOUT_US_MEDIUM    1000000   /* 1 s    */
+    #define TIMEOUT_US_SMALL     1000      /* 1 ms   */
+#endif
+
 #ifndef PLATFORM_OVERRIDE_MAX_BDF
     #define PCIE_MAX_BUS   256
     #define PCIE_MAX_DEV    32
@@ -450,6 +474,8 @@ uint32_t pal_pci_cfg_read(uint32_t bus, uint32_t dev, uint32_t func, int offset,
 
 uint64_t pal_pcie_get_mcfg_ecam(uint32_t bdf);
 void     pal_pcie_create_info_table(PCIE_INFO_TABLE *PcieTable);
+void     pal_pcie_free_info_table(void);
+uint32_t pal_pcie_get_num_ecam(void);
 uint32_t pal_pcie_io_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data);
 uint32_t pal_pcie_get_bdf_wrapper(uint32_t class_code, uint32_t start_bdf);
 void *pal_pci_bdf_to_dev(uint32_t bdf);
@@ -786,6 +812,12 @@ int      pal_mem_compare(void *src, void *dest, uint32_t len);
 void     pal_mem_set(void *buf, uint32_t size, uint8_t value);
 void    *pal_mem_virt_to_phys(void *va);
 void    *pal_mem_phys_to_virt(uint64_t pa);
+#ifdef TARGET_BM_BOOT
+uint32_t pal_mem_arena_checkpoint(void);
+uint64_t pal_mem_arena_release(uint32_t checkpoint);
+void     pal_mem_arena_keep(void *buffer);
+void     pal_mem_heap_stats(uint64_t *live, uint64_t *peak);
+#endif
 
 uint64_t pal_time_delay_ms(uint64_t time_ms);
 void     pal_mem_allocate_shared(uint32_t num_pe, uint32_t sizeofentry);
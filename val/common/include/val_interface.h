@@ -50,6 +50,33 @@ typedef char char8_t;
 void val_allocate_shared_mem(void);
 void val_free_shared_mem(void);
 void val_print(uint32_t level, char8_t *string, uint64_t data);
+void val_print_flush(void);
+uint32_t val_print_buffer_enable(uint32_t enable);
+void val_result_stream_enable(uint32_t enable);
+void val_report_result_record(uint32_t test_num, uint32_t index, uint32_t status,
+                              char8_t *ruleid);
+
+/* Per test phase timing, built in with -DACS_PROFILE (cmake -DACS_PROFILE=ON) */
+typedef enum {
+  VAL_PROFILE_INIT,
+  VAL_PROFILE_DISPATCH,
+  VAL_PROFILE_PAYLOAD,
+  VAL_PROFILE_WAIT,
+  VAL_PROFILE_REPORT,
+  VAL_PROFILE_PHASE_MAX
+} VAL_PROFILE_PHASE_e;
+
+#ifdef ACS_PROFILE
+void val_profile_phase_begin(uint32_t phase);
+void val_profile_phase_end(uint32_t phase);
+void val_profile_pe_payload(uint32_t index, uint64_t start_ticks);
+void val_profile_report(void);
+#else
+#define val_profile_phase_begin(phase)               ((void)0)
+#define val_profile_phase_end(phase)                 ((void)0)
+#define val_profile_pe_payload(index, start_ticks)   ((void)0)
+#define val_profile_report()                         ((void)0)
+#endif
 void val_print_raw(uint64_t uart_addr, uint32_t level, char8_t *string,
                                                                 uint64_t data);
 void val_print_primary_pe(uint32_t level, char8_t *string, uint64_t data, uint32_t index);
@@ -60,6 +87,8 @@ void val_get_test_data(uint32_t index, uint64_t *data0, uint64_t *data1);
 uint32_t val_strncmp(char8_t *str1, char8_t *str2, uint32_t len);
 void    *val_memcpy(void *dest_buffer, void *src_buffer, uint32_t len);
 uint64_t val_time_delay_ms(uint64_t time_ms);
+uint64_t val_get_counter(void);
+uint64_t val_time_us_to_ticks(uint64_t time_us);
 
 /* VAL PE APIs */
 
@@ -87,6 +116,8 @@ void     val_smbios_free_info_table(void);
 uint32_t val_get_num_smbios_slots(void);
 
 void     val_execute_on_pe(uint32_t index, void (*payload)(void), uint64_t args);
+void     val_execute_on_all_pe(uint32_t num_pe, void (*payload)(void), uint64_t args);
+uint32_t val_pe_pool_enable(uint32_t enable);
 uint32_t val_pe_feat_check(PE_FEAT_NAME pe_feature);
 
 /* GIC VAL APIs */
@@ -169,18 +200,26 @@ void     val_wd_free_info_table(void);
 uint64_t val_wd_get_info(uint32_t index, WD_INFO_TYPE_e info_type);
 
 /* PCIE VAL APIs */
+#define PCIE_ENUM_BRUTE_FORCE  0   /* Probe every function of every bus in the ECAM regions */
+#define PCIE_ENUM_TOPOLOGY     1   /* Scan the buses reached through bridges, skip absent functions */
+
+void     val_pcie_set_enum_mode(uint32_t mode);
+void     val_pcie_set_cfg_dump(uint32_t enable);
 void     val_pcie_enumerate(void);
 void     val_pcie_create_info_table(uint64_t *pcie_info_table);
 uint32_t val_pcie_create_device_bdf_table(void);
 addr_t val_pcie_get_ecam_base(uint32_t rp_bdf);
 void *val_pcie_bdf_table_ptr(void);
+uint32_t val_pcie_get_bdf_table_index(uint32_t bdf, uint32_t *index);
 void     val_pcie_free_info_table(void);
+uint32_t val_pcie_get_num_ecam(void);
 void val_pcie_read_ext_cap_word(uint32_t bdf, uint32_t ext_cap_id, uint8_t offset, uint16_t *val);
 uint32_t val_pcie_get_pcie_type(uint32_t bdf);
 uint32_t val_pcie_p2p_support(void);
 uint32_t val_pcie_dev_p2p_support(uint32_t bdf);
 uint32_t val_pcie_is_onchip_peripheral(uint32_t bdf);
 uint32_t val_pcie_device_port_type(uint32_t bdf);
+void     val_pcie_cap_dir_invalidate(uint32_t bdf);
 uint32_t val_pcie_find_capability(uint32_t bdf, uint32_t cid_type,
                                            uint32_t cid, uint32_t *cid_offset);
 void val_pcie_disable_bme(uint32_t bdf);
@@ -19,11 +19,24 @@
 #include "common/include/acs_gic.h"
 #include "common/include/acs_gic_support.h"
 #include "common/include/acs_common.h"
+#include "common/include/acs_memory.h"
 #include "common/sys_arch_src/gic/gic.h"
 #include "bsa/include/bsa_pal_interface.h"
 
 GIC_INFO_TABLE  *g_gic_info_table;
 
+/* Redistributor frames sorted by GICR_TYPER affinity, see val_gic_get_pe_rdbase */
+typedef struct {
+  uint64_t affinity;
+  uint64_t rd_base;
+} GIC_RDBASE_ENTRY;
+
+static GIC_RDBASE_ENTRY *g_gic_rdbase_table;
+static uint32_t         g_gic_rdbase_num;
+static uint32_t         g_gic_rdbase_done;
+
+static void gic_free_rdbase_table(void);
+
 /**
   @brief   This API will call PAL layer to fill in the GIC information
            into the g_gic_info_table pointer.
@@ -71,6 +84,9 @@ val_gic_create_info_table(uint64_t *gic_info_table)
       return ACS_STATUS_ERR;
   }
 
+  /* The redistributor lookup table is rebuilt on the next lookup */
+  gic_free_rdbase_table();
+
 #if !defined(SBSA) && !defined(DRTM)
   if (pal_target_is_dt())
       val_gic_init();
@@ -92,6 +108,8 @@ val_gic_create_info_table(uint64_t *gic_info_table)
 void
 val_gic_free_info_table(void)
 {
+    gic_free_rdbase_table();
+
     if (g_gic_info_table != NULL) {
         pal_mem_free_aligned((void *)g_gic_info_table);
         g_gic_info_table = NULL;
@@ -148,32 +166,40 @@ uint32_t val_get_num_nongic_ctrl(void)
 
 
 /**
-  @brief   This API returns the base address of the GIC Redistributor for a PE
-           1. Caller       -  Test Suite
-           2. Prerequisite -  val_gic_create_info_table
-  @param   mpidr - PE mpidr value
-  @return  Address of GIC Redistributor
+  @brief   Return the size of the GICR frames of a redistributor
+  @param   None
+  @return  Redistributor stride
 **/
-addr_t
-val_gic_get_pe_rdbase(uint64_t mpidr)
+static uint64_t gic_get_rd_granularity(void)
 {
-  uint32_t     gicrd_baselen;
-  uint32_t     gicr_rdindex = 0;
-  uint32_t     gic_version;
-  uint64_t     affinity, pe_affinity;
   uint64_t     gicrd_granularity;
-  uint64_t     gicrd_base, pe_gicrd_base;
-
-  pe_affinity = (mpidr & (PE_AFF0 | PE_AFF1 | PE_AFF2)) | ((mpidr & PE_AFF3) >> 8);
-  gic_version = val_gic_get_info(GIC_INFO_VERSION);
 
   gicrd_granularity = GICR_CTLR_FRAME_SIZE + GICR_SGI_PPI_FRAME_SIZE;
 
   /* Redistributors in GICv4 define 2 additional 64KB frames - One each for VLPI and Reserved */
-  if (gic_version > 3)
+  if (val_gic_get_info(GIC_INFO_VERSION) > 3)
     gicrd_granularity += GICR_VLPI_FRAME_SIZE + GICR_RES_FRAME_SIZE;
 
-  gicr_rdindex = 0;
+  return gicrd_granularity;
+}
+
+/**
+  @brief   Walk the redistributor frames reading GICR_TYPER until a frame matches
+           the affinity. Used when the lookup table has no entry for the affinity,
+           and to cross-check the table at debug verbosity.
+  @param   pe_affinity - Aff3.Aff2.Aff1.Aff0 of the PE
+  @return  Address of GIC Redistributor
+**/
+static addr_t
+gic_walk_pe_rdbase(uint64_t pe_affinity)
+{
+  uint32_t     gicrd_baselen;
+  uint32_t     gicr_rdindex = 0;
+  uint64_t     affinity, typer;
+  uint64_t     gicrd_granularity;
+  uint64_t     gicrd_base, pe_gicrd_base;
+
+  gicrd_granularity = gic_get_rd_granularity();
 
   /* If System doesn't have GICR RD strcture, then use GICCC RD base */
   if (g_gic_info_table->header.num_gicr_rd == 0) {
@@ -200,13 +226,16 @@ val_gic_get_pe_rdbase(uint64_t mpidr)
       pe_gicrd_base = gicrd_base;
       while (pe_gicrd_base < (gicrd_base + gicrd_baselen))
       {
-          val_print(ACS_PRINT_INFO, "       GICR_TYPER 0x%lx\n",
-                    val_mmio_read64(pe_gicrd_base + GICR_TYPER));
-
-          affinity = (val_mmio_read64(pe_gicrd_base + GICR_TYPER) & GICR_TYPER_AFF) >> 32;
+          typer = val_mmio_read64(pe_gicrd_base + GICR_TYPER);
+          affinity = (typer & GICR_TYPER_AFF) >> 32;
+          val_print(ACS_PRINT_INFO, "       GICR_TYPER affinity 0x%lx\n", affinity);
           if (affinity == pe_affinity)
               return pe_gicrd_base;
 
+          /* GICR_TYPER.Last marks the final frame of the region */
+          if (typer & GICR_TYPER_LAST)
+              break;
+
           /* Move to the next GIC Redistributor frame */
           pe_gicrd_base += gicrd_granularity;
       }
@@ -216,6 +245,166 @@ val_gic_get_pe_rdbase(uint64_t mpidr)
   return 0;
 }
 
+/**
+  @brief   Visit every redistributor frame described by the GIC info table, the
+           frames of each GICR structure, or the frame of each GICC structure.
+           A GICR structure ends at its length or at the frame with GICR_TYPER.Last.
+  @param   table - output frames, or NULL to only bound their number from the
+                   structure lengths without reading GICR_TYPER
+  @return  Number of frames
+**/
+static uint32_t
+gic_collect_rd_frames(GIC_RDBASE_ENTRY *table)
+{
+  uint32_t        num = 0;
+  uint32_t        use_gicc;
+  uint64_t        gicrd_granularity;
+  uint64_t        frame, typer;
+  GIC_INFO_ENTRY  *gic_entry;
+
+  gicrd_granularity = gic_get_rd_granularity();
+  use_gicc = (g_gic_info_table->header.num_gicr_rd == 0);
+
+  for (gic_entry = g_gic_info_table->gic_info; gic_entry->type != 0xFF; gic_entry++) {
+      if (use_gicc && (gic_entry->type == ENTRY_TYPE_GICC_GICRD)) {
+          if (table) {
+              table[num].rd_base = gic_entry->base;
+              table[num].affinity =
+                  (val_mmio_read64(gic_entry->base + GICR_TYPER) & GICR_TYPER_AFF) >> 32;
+          }
+          num++;
+      }
+
+      if (!use_gicc && (gic_entry->type == ENTRY_TYPE_GICR_GICRD)) {
+          for (frame = gic_entry->base; frame < gic_entry->base + gic_entry->length;
+               frame += gicrd_granularity) {
+              if (table == NULL) {
+                  num++;
+                  continue;
+              }
+
+              typer = val_mmio_read64(frame + GICR_TYPER);
+              table[num].rd_base = frame;
+              table[num].affinity = (typer & GICR_TYPER_AFF) >> 32;
+              num++;
+
+              if (typer & GICR_TYPER_LAST)
+                  break;
+          }
+      }
+  }
+
+  return num;
+}
+
+/**
+  @brief   Read GICR_TYPER of every redistributor frame once and keep the frames
+           sorted by affinity, so that val_gic_get_pe_rdbase does no MMIO.
+           Built on the first lookup, so that applications which never look up a
+           redistributor do not touch the GICR frames.
+           1. Caller       -  val_gic_get_pe_rdbase
+  @param   None
+  @return  None
+**/
+static void
+gic_create_rdbase_table(void)
+{
+  uint32_t          i, j, num;
+  GIC_RDBASE_ENTRY  entry;
+
+  gic_free_rdbase_table();
+  g_gic_rdbase_done = 1;
+
+  if (g_gic_info_table == NULL)
+      return;
+
+  num = gic_collect_rd_frames(NULL);
+  if (num == 0)
+      return;
+
+  g_gic_rdbase_table = pal_mem_alloc(num * sizeof(GIC_RDBASE_ENTRY));
+  if (g_gic_rdbase_table == NULL) {
+      val_print(ACS_PRINT_WARN, "\n       GICR lookup table allocation failed", 0);
+      return;
+  }
+
+  /* Built by the first test to look up a redistributor, kept for the later ones */
+  val_memory_arena_keep(g_gic_rdbase_table);
+
+  num = gic_collect_rd_frames(g_gic_rdbase_table);
+
+  /* Stable insertion sort, frames are normally already in affinity order */
+  for (i = 1; i < num; i++) {
+      entry = g_gic_rdbase_table[i];
+      for (j = i; (j > 0) && (g_gic_rdbase_table[j - 1].affinity > entry.affinity); j--)
+          g_gic_rdbase_table[j] = g_gic_rdbase_table[j - 1];
+      g_gic_rdbase_table[j] = entry;
+  }
+
+  g_gic_rdbase_num = num;
+  val_print(ACS_PRINT_DEBUG, " GIC_INFO: GICR frames indexed        : %4d\n", num);
+}
+
+static void
+gic_free_rdbase_table(void)
+{
+  if (g_gic_rdbase_table != NULL)
+      pal_mem_free(g_gic_rdbase_table);
+
+  g_gic_rdbase_table = NULL;
+  g_gic_rdbase_num = 0;
+  g_gic_rdbase_done = 0;
+}
+
+/**
+  @brief   This API returns the base address of the GIC Redistributor for a PE.
+           The frame is looked up in the table built on the first call, and found
+           with the GICR_TYPER walk if the table has no entry. At debug verbosity
+           every table hit is checked against the walk.
+           1. Caller       -  Test Suite
+           2. Prerequisite -  val_gic_create_info_table
+  @param   mpidr - PE mpidr value
+  @return  Address of GIC Redistributor
+**/
+addr_t
+val_gic_get_pe_rdbase(uint64_t mpidr)
+{
+  uint32_t     low, high, mid;
+  uint64_t     pe_affinity;
+  addr_t       rd_base = 0, walk_base;
+
+  if (!g_gic_rdbase_done)
+      gic_create_rdbase_table();
+
+  pe_affinity = (mpidr & (PE_AFF0 | PE_AFF1 | PE_AFF2)) | ((mpidr & PE_AFF3) >> 8);
+
+  /* Lower bound on the affinity */
+  low = 0;
+  high = g_gic_rdbase_num;
+  while (low < high) {
+      mid = low + (high - low) / 2;
+      if (g_gic_rdbase_table[mid].affinity < pe_affinity)
+          low = mid + 1;
+      else
+          high = mid;
+  }
+
+  if ((low < g_gic_rdbase_num) && (g_gic_rdbase_table[low].affinity == pe_affinity)) {
+      rd_base = g_gic_rdbase_table[low].rd_base;
+      if (g_print_level > ACS_PRINT_DEBUG)
+          return rd_base;
+  }
+
+  walk_base = gic_walk_pe_rdbase(pe_affinity);
+  if (rd_base && (rd_base != walk_base)) {
+      val_print(ACS_PRINT_ERR, "\n       GICR lookup mismatch for affinity 0x%lx", pe_affinity);
+      val_print(ACS_PRINT_ERR, ", table 0x%lx", rd_base);
+      val_print(ACS_PRINT_ERR, ", walk 0x%lx\n", walk_base);
+  }
+
+  return walk_base;
+}
+
 /**
   @brief   This API returns the base address of the GIC Redistributor
            1. Caller       -  Test Suite
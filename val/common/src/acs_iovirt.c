@@ -19,10 +19,44 @@
 #include "common/include/acs_common.h"
 #include "common/include/acs_iovirt.h"
 #include "common/include/acs_smmu.h"
+#include "common/include/acs_memory.h"
 
 IOVIRT_INFO_TABLE *g_iovirt_info_table;
 uint32_t g_num_smmus;
 
+/* Fully resolved RID ranges sorted on (segment, rid_base), see val_iovirt_get_device_info */
+typedef struct {
+  uint32_t segment;
+  uint32_t rid_base;
+  uint32_t rid_last;
+  uint32_t status;              /* IOVIRT_RID_MAP_OK or the reason the lookup fails */
+  uint32_t sid_base;            /* ~0 if the RC maps straight to an ITS group */
+  uint32_t did_base;
+  uint32_t its_id;
+} IOVIRT_RID_MAP;
+
+#define IOVIRT_RID_MAP_OK        0
+#define IOVIRT_RID_MAP_NO_DID    1    /* Stream ID not in the SMMU ID mappings */
+#define IOVIRT_RID_MAP_BAD_NODE  2    /* RC mapping output is not an SMMU or ITS group */
+
+/* ID range resolved to the ID mapping that serves it */
+typedef struct {
+  uint32_t lo;
+  uint32_t hi;
+  ID_MAP   *map;
+} IOVIRT_SPAN;
+
+/* Spans of the ID mappings of an SMMU block, cached by block offset */
+typedef struct {
+  uint32_t oref;
+  uint32_t first;
+  uint32_t num;
+} IOVIRT_SMMU_SPANS;
+
+static IOVIRT_RID_MAP *g_iovirt_rid_map;
+static uint32_t       g_iovirt_rid_map_num;
+static uint32_t       g_iovirt_rid_map_max;
+
 /**
   @brief   This API is a single point of entry to retrieve
            SMMU information stored in the IoVirt Info table
@@ -147,7 +181,9 @@ val_iovirt_get_pcie_rc_info(PCIE_RC_INFO_e type, uint32_t index)
 }
 
 /**
-  @brief  Calculate the device id and stream id orresponding to the requestor id
+  @brief  Resolve the device id and stream id of a requestor id by scanning the ID
+          mappings of every RC block and of the SMMU block they output to.
+          Used when the RID index could not be built.
   @param  rid          Requestor ID
   @param  segment      pci_segment_number
   @param  *device_id   Pointer to device id
@@ -155,10 +191,9 @@ val_iovirt_get_pcie_rc_info(PCIE_RC_INFO_e type, uint32_t index)
   @param  *its_id      Pointer to its id
   @return status
 **/
-
-int
-val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
-                           uint32_t *stream_id, uint32_t *its_id)
+static int
+iovirt_scan_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
+                        uint32_t *stream_id, uint32_t *its_id)
 {
   uint32_t i, j, id = 0;
   uint32_t sid, did, oref;
@@ -166,15 +201,6 @@ val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
   uint32_t mapping_found;
   IOVIRT_BLOCK *block;
   NODE_DATA_MAP *map;
-  if (g_iovirt_info_table == NULL)
-  {
-      val_print(ACS_PRINT_ERR, "\n       GET_DEVICE_ID: iovirt info table is not created", 0);
-      return ACS_STATUS_ERR;
-  }
-  if (!device_id) {
-      val_print(ACS_PRINT_ERR, "\n       GET_DEVICE_ID: Invalid parameters", 0);
-      return ACS_STATUS_ERR;
-  }
 
   /* Search for root complex block with same segment number, and in whose id */
   /* mapping range 'rid' falls. Calculate the output id */
@@ -255,6 +281,454 @@ val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
   return 0;
 }
 
+/**
+  @brief  Grow an array by doubling until it holds at least num elements.
+  @param  buf        Array, freed when it is moved
+  @param  max        Capacity in elements, updated
+  @param  num        Elements needed
+  @param  elem_size  Element size
+  @return Array, NULL on allocation failure
+**/
+static void *
+iovirt_grow(void *buf, uint32_t *max, uint32_t num, uint32_t elem_size)
+{
+  uint32_t new_max;
+  void *new_buf;
+
+  if (num <= *max)
+      return buf;
+
+  new_max = (*max) ? *max : 16;
+  while (new_max < num)
+      new_max <<= 1;
+
+  new_buf = val_memory_alloc(new_max * elem_size);
+  if (new_buf == NULL)
+      return NULL;
+
+  if (buf != NULL) {
+      val_memcpy(new_buf, buf, (*max) * elem_size);
+      val_memory_free(buf);
+  }
+
+  *max = new_max;
+  return new_buf;
+}
+
+/**
+  @brief  Resolve ID mappings, where the first mapping holding an ID serves it, into
+          sorted non-overlapping spans.
+  @param  maps    Mappings in priority order
+  @param  num     Number of mappings
+  @param  order   Scratch of num entries
+  @param  bounds  Scratch of 2 * num entries
+  @param  spans   Output of 2 * num entries
+  @return Number of spans
+**/
+static uint32_t
+iovirt_resolve_spans(ID_MAP **maps, uint32_t num, uint32_t *order, uint64_t *bounds,
+                     IOVIRT_SPAN *spans)
+{
+  uint32_t i, j, k, m, num_bounds, num_spans = 0;
+  uint32_t overlap = 0;
+  uint64_t lo, hi, b;
+
+  /* Stable sort on input base */
+  for (i = 0; i < num; i++) {
+      for (j = i; (j > 0) && (maps[order[j - 1]]->input_base > maps[i]->input_base); j--)
+          order[j] = order[j - 1];
+      order[j] = i;
+  }
+
+  for (i = 1; i < num; i++)
+      if ((uint64_t)maps[order[i - 1]]->input_base + maps[order[i - 1]]->id_count >=
+          maps[order[i]]->input_base)
+          overlap = 1;
+
+  /* Usual case, each ID is served by at most one mapping */
+  if (!overlap) {
+      for (i = 0; i < num; i++) {
+          hi = (uint64_t)maps[order[i]]->input_base + maps[order[i]]->id_count;
+          spans[i].lo = maps[order[i]]->input_base;
+          spans[i].hi = (hi > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)hi;
+          spans[i].map = maps[order[i]];
+      }
+      return num;
+  }
+
+  /* Overlapping mappings, split at every mapping boundary and keep the first
+     mapping in priority order for each piece */
+  num_bounds = 0;
+  for (i = 0; i < num; i++) {
+      lo = maps[i]->input_base;
+      hi = lo + maps[i]->id_count + 1;
+      for (k = 0; k < 2; k++) {
+          b = k ? hi : lo;
+          for (j = 0; (j < num_bounds) && (bounds[j] < b); j++)
+              ;
+          if ((j < num_bounds) && (bounds[j] == b))
+              continue;
+          for (m = num_bounds; m > j; m--)
+              bounds[m] = bounds[m - 1];
+          bounds[j] = b;
+          num_bounds++;
+      }
+  }
+
+  for (k = 0; k + 1 < num_bounds; k++) {
+      for (i = 0; i < num; i++)
+          if ((bounds[k] >= maps[i]->input_base) &&
+              (bounds[k] <= (uint64_t)maps[i]->input_base + maps[i]->id_count))
+              break;
+      if (i == num)
+          continue;
+
+      hi = bounds[k + 1] - 1;
+      if ((num_spans > 0) && (spans[num_spans - 1].map == maps[i]) &&
+          ((uint64_t)spans[num_spans - 1].hi + 1 == bounds[k])) {
+          spans[num_spans - 1].hi = (uint32_t)hi;
+          continue;
+      }
+
+      spans[num_spans].lo = (uint32_t)bounds[k];
+      spans[num_spans].hi = (hi > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)hi;
+      spans[num_spans].map = maps[i];
+      num_spans++;
+  }
+
+  return num_spans;
+}
+
+/**
+  @brief  Append a resolved RID range to the index.
+  @return 0 on success, 1 on allocation failure
+**/
+static uint32_t
+iovirt_rid_map_add(uint32_t segment, uint32_t rid_base, uint32_t rid_last, uint32_t status,
+                   uint32_t sid_base, uint32_t did_base, uint32_t its_id)
+{
+  IOVIRT_RID_MAP *entry;
+
+  entry = iovirt_grow(g_iovirt_rid_map, &g_iovirt_rid_map_max, g_iovirt_rid_map_num + 1,
+                      sizeof(IOVIRT_RID_MAP));
+  if (entry == NULL)
+      return 1;
+  g_iovirt_rid_map = entry;
+
+  entry = &g_iovirt_rid_map[g_iovirt_rid_map_num++];
+  entry->segment = segment;
+  entry->rid_base = rid_base;
+  entry->rid_last = rid_last;
+  entry->status = status;
+  entry->sid_base = sid_base;
+  entry->did_base = did_base;
+  entry->its_id = its_id;
+  return 0;
+}
+
+static void
+iovirt_free_rid_map(void)
+{
+  if (g_iovirt_rid_map != NULL)
+      val_memory_free(g_iovirt_rid_map);
+
+  g_iovirt_rid_map = NULL;
+  g_iovirt_rid_map_num = 0;
+  g_iovirt_rid_map_max = 0;
+}
+
+/**
+  @brief  Return the spans of the ID mappings of an SMMU block, resolving them on
+          first use.
+  @return Number of spans, *first set to the first span in the pool
+**/
+static uint32_t
+iovirt_get_smmu_spans(uint32_t oref, IOVIRT_SMMU_SPANS *cache, uint32_t *num_cached,
+                      uint32_t max_cached, IOVIRT_SPAN *pool, uint32_t *pool_used,
+                      uint32_t pool_size, ID_MAP **maps, uint32_t *order, uint64_t *bounds,
+                      uint32_t *first)
+{
+  uint32_t i;
+  IOVIRT_BLOCK *block;
+
+  for (i = 0; i < *num_cached; i++) {
+      if (cache[i].oref == oref) {
+          *first = cache[i].first;
+          return cache[i].num;
+      }
+  }
+
+  block = (IOVIRT_BLOCK *)((uint8_t *)g_iovirt_info_table + oref);
+  if ((*num_cached == max_cached) ||
+      (*pool_used + 2 * block->num_data_map > pool_size))
+      return 0;
+
+  for (i = 0; i < block->num_data_map; i++)
+      maps[i] = &block->data_map[i].map;
+
+  cache[*num_cached].oref = oref;
+  cache[*num_cached].first = *pool_used;
+  cache[*num_cached].num = iovirt_resolve_spans(maps, block->num_data_map, order, bounds,
+                                                &pool[*pool_used]);
+  *pool_used += cache[*num_cached].num;
+  *first = cache[*num_cached].first;
+  return cache[(*num_cached)++].num;
+}
+
+/**
+  @brief  Add the index ranges of the RIDs lo..hi of a segment, which an RC ID
+          mapping translates to an SMMU block. The range is split on the stream id
+          mappings of the SMMU block.
+  @return 0 on success, 1 on allocation failure
+**/
+static uint32_t
+iovirt_rid_map_add_smmu(uint32_t segment, uint32_t lo, uint32_t hi, uint32_t id_lo,
+                        IOVIRT_SPAN *smmu_spans, uint32_t num_smmu_spans)
+{
+  uint32_t i, its_id, piece_hi;
+  uint64_t id_hi = (uint64_t)id_lo + (hi - lo);
+  IOVIRT_BLOCK *out;
+
+  /* First SMMU span that ends at or after id_lo */
+  for (i = 0; (i < num_smmu_spans) && (smmu_spans[i].hi < id_lo); i++)
+      ;
+
+  while (lo <= hi) {
+      if ((i == num_smmu_spans) || (smmu_spans[i].lo > id_lo)) {
+          /* Stream ids up to the next SMMU span have no device id */
+          piece_hi = ((i == num_smmu_spans) || ((uint64_t)smmu_spans[i].lo > id_hi)) ? hi :
+                     lo + (smmu_spans[i].lo - id_lo) - 1;
+          if (iovirt_rid_map_add(segment, lo, piece_hi, IOVIRT_RID_MAP_NO_DID, 0, 0, 0))
+              return 1;
+      } else {
+          piece_hi = ((uint64_t)smmu_spans[i].hi >= id_hi) ? hi :
+                     lo + (smmu_spans[i].hi - id_lo);
+          out = (IOVIRT_BLOCK *)((uint8_t *)g_iovirt_info_table +
+                                 smmu_spans[i].map->output_ref);
+          its_id = (out->type == IOVIRT_NODE_ITS_GROUP) ? out->data_map[0].id[0] : 0;
+          if (iovirt_rid_map_add(segment, lo, piece_hi, IOVIRT_RID_MAP_OK, id_lo,
+                                 id_lo - smmu_spans[i].map->input_base +
+                                 smmu_spans[i].map->output_base, its_id))
+              return 1;
+          i++;
+      }
+
+      if (piece_hi == hi)
+          break;
+      id_lo += piece_hi - lo + 1;
+      lo = piece_hi + 1;
+  }
+
+  return 0;
+}
+
+/**
+  @brief  Index the RID to stream id / device id translation of every PCIe segment.
+          The RC ID mappings of a segment are resolved with the precedence of
+          iovirt_scan_device_info, the last RC block and its first mapping holding
+          the RID, and ranges output to an SMMU are split on the SMMU ID mappings.
+          Lookups then binary search (segment, RID) ranges.
+          1. Caller       -  val_iovirt_create_info_table
+  @param  None
+  @return None
+**/
+static void
+iovirt_create_rid_map(void)
+{
+  uint32_t i, j, n, num_rc_maps = 0, num_smmu_maps = 0, num_smmu_blocks = 0;
+  uint32_t max_maps = 0, num_spans, num_smmu_spans, first = 0, num_cached = 0, pool_used = 0;
+  uint32_t segment, found;
+  uint64_t next_segment;
+  uint32_t *order = NULL;
+  uint64_t *bounds = NULL;
+  ID_MAP **maps = NULL;
+  IOVIRT_SPAN *spans = NULL, *pool = NULL;
+  IOVIRT_SMMU_SPANS *cache = NULL;
+  IOVIRT_BLOCK *block, *out;
+
+  iovirt_free_rid_map();
+
+  block = &g_iovirt_info_table->blocks[0];
+  for (i = 0; i < g_iovirt_info_table->num_blocks; i++, block = IOVIRT_NEXT_BLOCK(block)) {
+      block = ALIGN_MEMORY_ACCESS(block);
+      if (block->type == IOVIRT_NODE_PCI_ROOT_COMPLEX)
+          num_rc_maps += block->num_data_map;
+      if (block->type == IOVIRT_NODE_SMMU || block->type == IOVIRT_NODE_SMMU_V3) {
+          num_smmu_maps += block->num_data_map;
+          num_smmu_blocks++;
+          max_maps = (block->num_data_map > max_maps) ? block->num_data_map : max_maps;
+      }
+  }
+
+  if (num_rc_maps == 0)
+      return;
+
+  max_maps = (num_rc_maps > max_maps) ? num_rc_maps : max_maps;
+  maps = val_memory_alloc(max_maps * sizeof(ID_MAP *));
+  order = val_memory_alloc(max_maps * sizeof(uint32_t));
+  bounds = val_memory_alloc(2 * max_maps * sizeof(uint64_t));
+  spans = val_memory_alloc(2 * max_maps * sizeof(IOVIRT_SPAN));
+  if (num_smmu_blocks) {
+      pool = val_memory_alloc(2 * num_smmu_maps * sizeof(IOVIRT_SPAN));
+      cache = val_memory_alloc(num_smmu_blocks * sizeof(IOVIRT_SMMU_SPANS));
+  }
+  if (!maps || !order || !bounds || !spans || (num_smmu_blocks && (!pool || !cache)))
+      goto fail;
+
+  /* Segments in increasing order, so that the index comes out sorted */
+  next_segment = 0;
+  while (1) {
+      found = 0;
+      segment = 0xFFFFFFFF;
+      block = &g_iovirt_info_table->blocks[0];
+      for (i = 0; i < g_iovirt_info_table->num_blocks; i++, block = IOVIRT_NEXT_BLOCK(block)) {
+          block = ALIGN_MEMORY_ACCESS(block);
+          if ((block->type == IOVIRT_NODE_PCI_ROOT_COMPLEX) &&
+              (block->data.rc.segment >= next_segment) && (block->data.rc.segment <= segment)) {
+              segment = block->data.rc.segment;
+              found = 1;
+          }
+      }
+      if (!found)
+          break;
+      next_segment = (uint64_t)segment + 1;
+
+      /* RC mappings of the segment in priority order, last block first */
+      n = 0;
+      block = &g_iovirt_info_table->blocks[0];
+      for (i = 0; i < g_iovirt_info_table->num_blocks; i++, block = IOVIRT_NEXT_BLOCK(block)) {
+          block = ALIGN_MEMORY_ACCESS(block);
+          if (block->type != IOVIRT_NODE_PCI_ROOT_COMPLEX || block->data.rc.segment != segment)
+              continue;
+          for (j = n; j > 0; j--)
+              maps[j - 1 + block->num_data_map] = maps[j - 1];
+          for (j = 0; j < block->num_data_map; j++)
+              maps[j] = &block->data_map[j].map;
+          n += block->num_data_map;
+      }
+
+      num_spans = iovirt_resolve_spans(maps, n, order, bounds, spans);
+
+      for (i = 0; i < num_spans; i++) {
+          out = (IOVIRT_BLOCK *)((uint8_t *)g_iovirt_info_table + spans[i].map->output_ref);
+
+          if (out->type == IOVIRT_NODE_ITS_GROUP) {
+              if (iovirt_rid_map_add(segment, spans[i].lo, spans[i].hi, IOVIRT_RID_MAP_OK,
+                                     ~((uint32_t)0), spans[i].lo - spans[i].map->input_base +
+                                     spans[i].map->output_base, out->data_map[0].id[0]))
+                  goto fail;
+          } else if (out->type == IOVIRT_NODE_SMMU || out->type == IOVIRT_NODE_SMMU_V3) {
+              num_smmu_spans = iovirt_get_smmu_spans(spans[i].map->output_ref, cache,
+                                                     &num_cached, num_smmu_blocks, pool,
+                                                     &pool_used, 2 * num_smmu_maps,
+                                                     maps, order, bounds, &first);
+              if ((num_smmu_spans == 0) && (out->num_data_map != 0))
+                  goto fail;
+              if (iovirt_rid_map_add_smmu(segment, spans[i].lo, spans[i].hi,
+                                          spans[i].lo - spans[i].map->input_base +
+                                          spans[i].map->output_base,
+                                          &pool[first], num_smmu_spans))
+                  goto fail;
+          } else {
+              if (iovirt_rid_map_add(segment, spans[i].lo, spans[i].hi,
+                                     IOVIRT_RID_MAP_BAD_NODE, 0, 0, 0))
+                  goto fail;
+          }
+      }
+  }
+
+  val_print(ACS_PRINT_DEBUG, " SMMU_INFO: RID ranges indexed        :    %d\n",
+            g_iovirt_rid_map_num);
+  goto done;
+
+fail:
+  val_print(ACS_PRINT_WARN, "\n       IORT RID index not built, using ID mapping scan", 0);
+  iovirt_free_rid_map();
+
+done:
+  if (maps)
+      val_memory_free(maps);
+  if (order)
+      val_memory_free(order);
+  if (bounds)
+      val_memory_free(bounds);
+  if (spans)
+      val_memory_free(spans);
+  if (pool)
+      val_memory_free(pool);
+  if (cache)
+      val_memory_free(cache);
+}
+
+/**
+  @brief  Calculate the device id and stream id orresponding to the requestor id
+  @param  rid          Requestor ID
+  @param  segment      pci_segment_number
+  @param  *device_id   Pointer to device id
+  @param  *stream_id   Pointer to stream id
+  @param  *its_id      Pointer to its id
+  @return status
+**/
+
+int
+val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
+                           uint32_t *stream_id, uint32_t *its_id)
+{
+  uint32_t low, high, mid;
+  IOVIRT_RID_MAP *entry;
+
+  if (g_iovirt_info_table == NULL)
+  {
+      val_print(ACS_PRINT_ERR, "\n       GET_DEVICE_ID: iovirt info table is not created", 0);
+      return ACS_STATUS_ERR;
+  }
+  if (!device_id) {
+      val_print(ACS_PRINT_ERR, "\n       GET_DEVICE_ID: Invalid parameters", 0);
+      return ACS_STATUS_ERR;
+  }
+
+  if (g_iovirt_rid_map == NULL)
+      return iovirt_scan_device_info(rid, segment, device_id, stream_id, its_id);
+
+  /* Last range starting at or before (segment, rid) */
+  low = 0;
+  high = g_iovirt_rid_map_num;
+  while (low < high) {
+      mid = low + (high - low) / 2;
+      entry = &g_iovirt_rid_map[mid];
+      if ((entry->segment < segment) ||
+          ((entry->segment == segment) && (entry->rid_base <= rid)))
+          low = mid + 1;
+      else
+          high = mid;
+  }
+
+  entry = (low > 0) ? &g_iovirt_rid_map[low - 1] : NULL;
+  if ((entry == NULL) || (entry->segment != segment) || (rid > entry->rid_last)) {
+      val_print(ACS_PRINT_ERR,
+             "\n       RID to Stream/Dev ID map not found ", 0);
+      return ACS_STATUS_ERR;
+  }
+
+  if (entry->status == IOVIRT_RID_MAP_BAD_NODE) {
+      val_print(ACS_PRINT_ERR, "\n       GET_DEVICE_ID: Invalid mapping for RC in IORT", 0);
+      return ACS_STATUS_ERR;
+  }
+  if (entry->status == IOVIRT_RID_MAP_NO_DID) {
+      val_print(ACS_PRINT_ERR,
+                        "\n       GET_DEVICE_ID: Stream ID to Device ID mapping not found", 0);
+      return ACS_STATUS_ERR;
+  }
+
+  if (its_id)
+      *its_id = entry->its_id;
+  if (stream_id)
+      *stream_id = (entry->sid_base == ~((uint32_t)0)) ? entry->sid_base :
+                   entry->sid_base + (rid - entry->rid_base);
+  *device_id = entry->did_base + (rid - entry->rid_base);
+  return 0;
+}
+
 /**
   @brief   This API will call PAL layer to fill in the IO Virt information
            into the g_iovirt_info_table pointer.
@@ -279,6 +753,7 @@ val_iovirt_create_info_table(uint64_t *iovirt_info_table)
   g_iovirt_info_table = (IOVIRT_INFO_TABLE *)iovirt_info_table;
 
   pal_iovirt_create_info_table(g_iovirt_info_table);
+  iovirt_create_rid_map();
 
   g_num_smmus = (uint32_t)val_iovirt_get_smmu_info(SMMU_NUM_CTRL, 0);
   val_print(ACS_PRINT_TEST,
@@ -308,6 +783,8 @@ val_iovirt_create_info_table(uint64_t *iovirt_info_table)
 void
 val_iovirt_free_info_table(void)
 {
+    iovirt_free_rid_map();
+
     if (g_iovirt_info_table != NULL) {
         pal_mem_free_aligned((void *)g_iovirt_info_table);
         g_iovirt_info_table = NULL;
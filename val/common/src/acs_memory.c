@@ -20,6 +20,7 @@
 #include "common/include/acs_memory.h"
 #include "common/include/acs_common.h"
 #include "common/include/acs_mmu.h"
+#include "common/include/acs_pgt.h"
 #include "common/include/val_interface.h"
 #include "bsa/include/bsa_val_interface.h"
 
@@ -352,6 +353,72 @@ void
 
 }
 
+#ifdef TARGET_BM_BOOT
+/**
+  @brief  Open a heap arena, memory allocated from now on is accounted to it.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @return Checkpoint to pass to val_memory_arena_release
+**/
+uint32_t
+val_memory_arena_checkpoint(void)
+{
+  return pal_mem_arena_checkpoint();
+}
+
+/**
+  @brief  Close a heap arena, the PAL may reclaim the memory left allocated in it.
+          1. Caller       - VAL
+          2. Prerequisite - val_memory_arena_checkpoint
+
+  @param  checkpoint  value returned by val_memory_arena_checkpoint
+
+  @return Bytes left allocated in the arena
+**/
+uint64_t
+val_memory_arena_release(uint32_t checkpoint)
+{
+  return pal_mem_arena_release(checkpoint);
+}
+
+/**
+  @brief  Heap usage statistics.
+
+  @param  live  bytes currently allocated
+  @param  peak  highest number of bytes allocated at once
+
+  @return None
+**/
+void
+val_memory_heap_stats(uint64_t *live, uint64_t *peak)
+{
+  pal_mem_heap_stats(live, peak);
+}
+#endif  // TARGET_BM_BOOT
+
+/**
+  @brief  Keep a buffer allocated during a test which outlives the test, such
+          as a table built on first use and referenced from a global, out of
+          the heap arenas. It is then not reported as left allocated by the
+          test, nor reclaimed with the arena.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @param  addr  address returned by val_memory_alloc or val_memory_calloc
+
+  @return None
+**/
+void
+val_memory_arena_keep(void *addr)
+{
+#ifdef TARGET_BM_BOOT
+  pal_mem_arena_keep(addr);
+#else
+  (void)addr;
+#endif
+}
+
 /**
   @brief  Free Allocated buffer size by val_aligned_alloc.
 
@@ -377,6 +444,10 @@ uint32_t
 val_memory_set_wb_executable(void *addr, uint32_t size)
 {
 
+#ifndef TARGET_LINUX
+  /* The platform may rewrite the live translation tables */
+  val_pgt_walk_cache_invalidate();
+#endif
   return pal_mem_set_wb_executable(addr, size);
 
 }
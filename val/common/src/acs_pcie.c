@@ -31,6 +31,330 @@ uint32_t g_pcie_integrated_devices;
 uint64_t
 pal_get_mcfg_ptr(void);
 
+/* Number of entries g_pcie_bdf_table can hold, see val_pcie_bdf_table_add() */
+static uint32_t g_pcie_bdf_table_max;
+
+/* Enumeration mode of val_pcie_create_device_bdf_table, see val_pcie_set_enum_mode() */
+static uint32_t g_pcie_enum_mode = PCIE_ENUM_BRUTE_FORCE;
+
+/* Config space snapshot after enumeration, see val_pcie_set_cfg_dump() */
+static uint32_t g_pcie_cfg_dump;
+
+/* ECAM base of every bus of one PCIe segment, see val_pcie_create_ecam_lookup() */
+typedef struct {
+  uint32_t segment;
+  addr_t   ecam_base[PCIE_MAX_BUS];
+} PCIE_ECAM_LOOKUP;
+
+static PCIE_ECAM_LOOKUP *g_pcie_ecam_lookup;
+static uint32_t g_pcie_ecam_lookup_count;
+
+/**
+  @brief   Build the segment/bus to ECAM base lookup from the PCIe info table,
+           so that config accesses do not walk the ECAM regions.
+           The first region covering a bus wins, as in the region walk.
+  @param   None
+  @return  None
+**/
+static void
+val_pcie_create_ecam_lookup(void)
+{
+  uint32_t i, j, bus, end_bus;
+  uint32_t num_ecam = g_pcie_info_table->num_entries;
+  PCIE_INFO_BLOCK *block;
+  PCIE_ECAM_LOOKUP *entry;
+
+  if (g_pcie_ecam_lookup != NULL)
+      val_memory_free(g_pcie_ecam_lookup);
+
+  g_pcie_ecam_lookup = NULL;
+  g_pcie_ecam_lookup_count = 0;
+  if (num_ecam == 0)
+      return;
+
+  g_pcie_ecam_lookup = val_memory_calloc(num_ecam, sizeof(PCIE_ECAM_LOOKUP));
+  if (g_pcie_ecam_lookup == NULL) {
+      val_print(ACS_PRINT_WARN, "\n       ECAM lookup allocation failed, walking ECAM regions", 0);
+      return;
+  }
+
+  for (i = 0; i < num_ecam; i++) {
+      block = &g_pcie_info_table->block[i];
+
+      for (j = 0; j < g_pcie_ecam_lookup_count; j++) {
+          if (g_pcie_ecam_lookup[j].segment == block->segment_num)
+              break;
+      }
+
+      entry = &g_pcie_ecam_lookup[j];
+      if (j == g_pcie_ecam_lookup_count) {
+          entry->segment = block->segment_num;
+          g_pcie_ecam_lookup_count++;
+      }
+
+      end_bus = (block->end_bus_num < PCIE_MAX_BUS) ? block->end_bus_num : (PCIE_MAX_BUS - 1);
+      for (bus = block->start_bus_num; bus <= end_bus; bus++) {
+          if (entry->ecam_base[bus] == 0)
+              entry->ecam_base[bus] = block->ecam_base;
+      }
+  }
+}
+
+/**
+  @brief   Return the ECAM base of the region covering a segment and bus.
+  @param   segment - PCIe segment number
+  @param   bus     - Bus number, must be less than PCIE_MAX_BUS
+  @return  ECAM base address, 0 if no ECAM region covers the bus
+**/
+static addr_t
+val_pcie_lookup_ecam_base(uint32_t segment, uint32_t bus)
+{
+  uint32_t i;
+
+  if (g_pcie_ecam_lookup != NULL) {
+      for (i = 0; i < g_pcie_ecam_lookup_count; i++) {
+          if (g_pcie_ecam_lookup[i].segment == segment)
+              return g_pcie_ecam_lookup[i].ecam_base[bus];
+      }
+      return 0;
+  }
+
+  for (i = 0; i < g_pcie_info_table->num_entries; i++) {
+      if ((bus >= g_pcie_info_table->block[i].start_bus_num) &&
+          (bus <= g_pcie_info_table->block[i].end_bus_num) &&
+          (segment == g_pcie_info_table->block[i].segment_num))
+          return g_pcie_info_table->block[i].ecam_base;
+  }
+
+  return 0;
+}
+
+/* Capability of a function, see val_pcie_create_cap_dir() */
+typedef struct {
+  uint16_t id;
+  uint16_t offset;
+} PCIE_CAP_DIR_ENTRY;
+
+/* Capability directory of a function, its PCI capabilities followed by its
+   extended capabilities in g_pcie_cap_dir_entry, in linked list order */
+typedef struct {
+  uint32_t bdf;
+  uint32_t first;
+  uint8_t  num_cap;
+  uint8_t  num_ecap;
+  uint8_t  valid;
+} PCIE_CAP_DIR;
+
+#define PCIE_CAP_DIR_MAX_CAPS  0xFF   /* Longer lists are not cached, they are walked */
+
+static PCIE_CAP_DIR *g_pcie_cap_dir;             /* Sorted by bdf */
+static uint32_t g_pcie_cap_dir_count;
+static PCIE_CAP_DIR_ENTRY *g_pcie_cap_dir_entry;
+static uint32_t g_pcie_cap_dir_entry_count;
+static uint32_t g_pcie_cap_dir_entry_size;
+
+/**
+  @brief   Append a capability to the directory entry pool, growing it if needed.
+  @param   id     - Capability ID
+  @param   offset - Capability offset in the function config space
+  @return  0 if success, 1 if the pool could not be grown
+**/
+static uint32_t
+val_pcie_cap_dir_add(uint32_t id, uint32_t offset)
+{
+  PCIE_CAP_DIR_ENTRY *entry;
+  uint32_t size;
+
+  if (g_pcie_cap_dir_entry_count == g_pcie_cap_dir_entry_size) {
+      size = g_pcie_cap_dir_entry_size ? (g_pcie_cap_dir_entry_size * 2) : 256;
+      entry = val_memory_alloc(size * sizeof(PCIE_CAP_DIR_ENTRY));
+      if (entry == NULL)
+          return 1;
+
+      if (g_pcie_cap_dir_entry != NULL) {
+          val_memcpy(entry, g_pcie_cap_dir_entry,
+                     g_pcie_cap_dir_entry_count * sizeof(PCIE_CAP_DIR_ENTRY));
+          val_memory_free(g_pcie_cap_dir_entry);
+      }
+      g_pcie_cap_dir_entry = entry;
+      g_pcie_cap_dir_entry_size = size;
+  }
+
+  g_pcie_cap_dir_entry[g_pcie_cap_dir_entry_count].id = id;
+  g_pcie_cap_dir_entry[g_pcie_cap_dir_entry_count].offset = offset;
+  g_pcie_cap_dir_entry_count++;
+
+  return 0;
+}
+
+/**
+  @brief   Walk the PCI and extended capability lists of a function into its
+           directory. The directory is left invalid if a list cannot be read
+           or is too long, so that lookups fall back to walking the lists.
+  @param   dir - Directory of the function, bdf filled in
+  @return  None
+**/
+static void
+val_pcie_cap_dir_fill(PCIE_CAP_DIR *dir)
+{
+  uint32_t reg_value;
+  uint32_t next_cap_offset;
+  uint32_t count;
+
+  dir->first = g_pcie_cap_dir_entry_count;
+  dir->num_cap = 0;
+  dir->num_ecap = 0;
+  dir->valid = 0;
+
+  if ((val_pcie_read_cfg(dir->bdf, TYPE01_CPR, &reg_value) != 0) ||
+      (reg_value == PCIE_UNKNOWN_RESPONSE))
+      return;
+
+  count = 0;
+  next_cap_offset = (reg_value & TYPE01_CPR_MASK);
+  while (next_cap_offset) {
+      if ((count == PCIE_CAP_DIR_MAX_CAPS) ||
+          val_pcie_read_cfg(dir->bdf, next_cap_offset, &reg_value) ||
+          val_pcie_cap_dir_add(reg_value & PCIE_CIDR_MASK, next_cap_offset))
+          goto invalid;
+      count++;
+      next_cap_offset = ((reg_value >> PCIE_NCPR_SHIFT) & PCIE_NCPR_MASK);
+  }
+  dir->num_cap = count;
+
+  count = 0;
+  next_cap_offset = PCIE_ECAP_START;
+  while (next_cap_offset) {
+      if ((count == PCIE_CAP_DIR_MAX_CAPS) ||
+          val_pcie_read_cfg(dir->bdf, next_cap_offset, &reg_value) ||
+          val_pcie_cap_dir_add(reg_value & PCIE_ECAP_CIDR_MASK, next_cap_offset))
+          goto invalid;
+      count++;
+      next_cap_offset = ((reg_value >> PCIE_ECAP_NCPR_SHIFT) & PCIE_ECAP_NCPR_MASK);
+  }
+  dir->num_ecap = count;
+  dir->valid = 1;
+  return;
+
+invalid:
+  /* Drop the partial entries of this function */
+  g_pcie_cap_dir_entry_count = dir->first;
+  dir->num_cap = 0;
+}
+
+/**
+  @brief   Build the capability directory of every function in the BDF table,
+           so that val_pcie_find_capability does not walk the capability lists.
+  @param   None
+  @return  None
+**/
+static void
+val_pcie_create_cap_dir(void)
+{
+  uint32_t i, j;
+  PCIE_CAP_DIR dir;
+
+  if (g_pcie_bdf_table->num_entries == 0)
+      return;
+
+  g_pcie_cap_dir = val_memory_calloc(g_pcie_bdf_table->num_entries, sizeof(PCIE_CAP_DIR));
+  if (g_pcie_cap_dir == NULL) {
+      val_print(ACS_PRINT_WARN, "\n       Capability directory allocation failed", 0);
+      return;
+  }
+
+  for (i = 0; i < g_pcie_bdf_table->num_entries; i++) {
+      dir.bdf = g_pcie_bdf_table->device[i].bdf;
+      val_pcie_cap_dir_fill(&dir);
+
+      /* Insert in bdf order, the BDF table is already sorted within an ECAM region */
+      for (j = g_pcie_cap_dir_count; (j > 0) && (g_pcie_cap_dir[j - 1].bdf > dir.bdf); j--)
+          g_pcie_cap_dir[j] = g_pcie_cap_dir[j - 1];
+      g_pcie_cap_dir[j] = dir;
+      g_pcie_cap_dir_count++;
+  }
+}
+
+/**
+  @brief   Find the capability directory of a function.
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return  Directory of the function, NULL if it has no valid directory
+**/
+static PCIE_CAP_DIR *
+val_pcie_get_cap_dir(uint32_t bdf)
+{
+  uint32_t low = 0;
+  uint32_t high = g_pcie_cap_dir_count;
+  uint32_t mid;
+
+  while (low < high) {
+      mid = low + ((high - low) / 2);
+      if (g_pcie_cap_dir[mid].bdf == bdf)
+          return g_pcie_cap_dir[mid].valid ? &g_pcie_cap_dir[mid] : NULL;
+      if (g_pcie_cap_dir[mid].bdf < bdf)
+          low = mid + 1;
+      else
+          high = mid;
+  }
+
+  return NULL;
+}
+
+/**
+  @brief   Drop the cached capability directory of a function, to be called
+           when a test resets or reprograms the function. Later lookups for
+           the function walk its capability lists.
+           1. Caller       -  Test Suite
+           2. Prerequisite -  val_pcie_create_info_table
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return  None
+**/
+void
+val_pcie_cap_dir_invalidate(uint32_t bdf)
+{
+  PCIE_CAP_DIR *dir = val_pcie_get_cap_dir(bdf);
+
+  if (dir != NULL)
+      dir->valid = 0;
+}
+
+/**
+  @brief   Free the capability directory.
+  @param   None
+  @return  None
+**/
+static void
+val_pcie_free_cap_dir(void)
+{
+  if (g_pcie_cap_dir != NULL)
+      val_memory_free(g_pcie_cap_dir);
+  if (g_pcie_cap_dir_entry != NULL)
+      val_memory_free(g_pcie_cap_dir_entry);
+
+  g_pcie_cap_dir = NULL;
+  g_pcie_cap_dir_entry = NULL;
+  g_pcie_cap_dir_count = 0;
+  g_pcie_cap_dir_entry_count = 0;
+  g_pcie_cap_dir_entry_size = 0;
+}
+
+/**
+  @brief   This API selects how val_pcie_create_device_bdf_table finds the
+           functions. PCIE_ENUM_BRUTE_FORCE probes every function of every bus
+           in the ECAM regions. PCIE_ENUM_TOPOLOGY only scans the root bus of a
+           region and the buses behind the bridges found, and skips functions
+           1-7 of absent and single function devices.
+           1. Caller       -  Application layer
+           2. Prerequisite -  None, to be called before val_pcie_create_info_table
+  @param   mode - PCIE_ENUM_BRUTE_FORCE or PCIE_ENUM_TOPOLOGY
+  @return  None
+**/
+void
+val_pcie_set_enum_mode(uint32_t mode)
+{
+  g_pcie_enum_mode = mode;
+}
+
 /**
   @brief   This API reads 32-bit data from PCIe config space pointed by Bus,
            Device, Function and register offset.
@@ -51,7 +375,6 @@ val_pcie_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data)
   uint32_t segment = PCIE_EXTRACT_BDF_SEG(bdf);
   uint32_t cfg_addr;
   addr_t   ecam_base = 0;
-  uint32_t i = 0;
 
   if ((bus >= PCIE_MAX_BUS) || (dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC)) {
      val_print(ACS_PRINT_ERR, "\n       Invalid Bus/Dev/Func  %x", bdf);
@@ -63,17 +386,7 @@ val_pcie_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data)
       return PCIE_NO_MAPPING;
   }
 
-  while (i < (uint32_t)val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0))
-  {
-
-      if ((bus >= (uint32_t)val_pcie_get_info(PCIE_INFO_START_BUS, i)) &&
-           (bus <= (uint32_t)val_pcie_get_info(PCIE_INFO_END_BUS, i)) &&
-           (segment == (uint32_t)val_pcie_get_info(PCIE_INFO_SEGMENT, i))) {
-          ecam_base = val_pcie_get_info(PCIE_INFO_ECAM, i);
-          break;
-      }
-      i++;
-  }
+  ecam_base = val_pcie_lookup_ecam_base(segment, bus);
 
   if (ecam_base == 0) {
       val_print(ACS_PRINT_ERR, "\n       PCIe_CFG_RD ECAM Base is zero %.8x", bdf);
@@ -126,7 +439,6 @@ val_pcie_write_cfg(uint32_t bdf, uint32_t offset, uint32_t data)
   uint32_t segment  = PCIE_EXTRACT_BDF_SEG(bdf);
   uint32_t cfg_addr;
   addr_t   ecam_base = 0;
-  uint32_t i = 0;
 
 
   if ((bus >= PCIE_MAX_BUS) || (dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC)) {
@@ -139,17 +451,7 @@ val_pcie_write_cfg(uint32_t bdf, uint32_t offset, uint32_t data)
       return;
   }
 
-  while (i < (uint32_t)val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0))
-  {
-
-      if ((bus >= (uint32_t)val_pcie_get_info(PCIE_INFO_START_BUS, i)) &&
-           (bus <= (uint32_t)val_pcie_get_info(PCIE_INFO_END_BUS, i)) &&
-           (segment == (uint32_t)val_pcie_get_info(PCIE_INFO_SEGMENT, i))) {
-          ecam_base = val_pcie_get_info(PCIE_INFO_ECAM, i);
-          break;
-      }
-      i++;
-  }
+  ecam_base = val_pcie_lookup_ecam_base(segment, bus);
 
   if (ecam_base == 0) {
       val_print(ACS_PRINT_ERR, "\n       PCIe_CFG_WR ECAM Base is zero %.8x", bdf);
@@ -233,9 +535,7 @@ uint64_t val_pcie_get_bdf_config_addr(uint32_t bdf)
   uint32_t func     = PCIE_EXTRACT_BDF_FUNC(bdf);
   uint32_t segment  = PCIE_EXTRACT_BDF_SEG(bdf);
   uint32_t cfg_addr;
-  uint32_t num_ecam;
   addr_t   ecam_base = 0;
-  uint32_t i = 0;
 
   if ((bus >= PCIE_MAX_BUS) || (dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC)) {
      val_print(ACS_PRINT_ERR, "\n       Invalid Bus/Dev/Func  %x", bdf);
@@ -247,18 +547,7 @@ uint64_t val_pcie_get_bdf_config_addr(uint32_t bdf)
       return 0;
   }
 
-  num_ecam = (uint32_t)val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0);
-  while (i < num_ecam)
-  {
-
-      if ((bus >= (uint32_t)val_pcie_get_info(PCIE_INFO_START_BUS, i)) &&
-           (bus <= (uint32_t)val_pcie_get_info(PCIE_INFO_END_BUS, i)) &&
-           (segment == (uint32_t)val_pcie_get_info(PCIE_INFO_SEGMENT, i))) {
-          ecam_base = val_pcie_get_info(PCIE_INFO_ECAM, i);
-          break;
-      }
-      i++;
-  }
+  ecam_base = val_pcie_lookup_ecam_base(segment, bus);
 
   if (ecam_base == 0) {
       val_print(ACS_PRINT_ERR, "\n       BDF config Read PCIe_CFG: ECAM Base is zero %x", bdf);
@@ -289,6 +578,110 @@ void val_pcie_enumerate(void)
   pal_pcie_enumerate();
 }
 
+/**
+  @brief   This API enables or disables the config space snapshot printed by
+           val_pcie_print_device_info, see val_pcie_dump_cfg_space.
+           1. Caller       -  Application layer.
+           2. Prerequisite -  Called before val_pcie_create_info_table.
+  @param   enable - 1 to print the snapshot, 0 to not print it
+  @return  None
+**/
+void
+val_pcie_set_cfg_dump(uint32_t enable)
+{
+  g_pcie_cfg_dump = enable;
+}
+
+/**
+  @brief   Print the config space of a function as ACSC records, see
+           val_pcie_dump_cfg_space. Stops at the first config read that fails.
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return  None
+**/
+static void
+val_pcie_dump_function(uint32_t bdf)
+{
+  uint32_t i;
+  uint32_t offset;
+  uint32_t reg_value[4];
+
+  for (offset = 0; offset < PCIE_CFG_SIZE; offset += sizeof(reg_value)) {
+      for (i = 0; i < 4; i++) {
+          if (val_pcie_read_cfg(bdf, offset + i * 4, &reg_value[i])) {
+              val_print(ACS_PRINT_WARN, "\n       Config read failed, dump of %x truncated", bdf);
+              return;
+          }
+      }
+
+      if (!(reg_value[0] | reg_value[1] | reg_value[2] | reg_value[3]))
+          continue;
+
+      val_print(ACS_PRINT_INFO, "\nACSC %06x", bdf);
+      val_print(ACS_PRINT_INFO, " %03x", offset);
+      for (i = 0; i < 4; i++)
+          val_print(ACS_PRINT_INFO, " %08x", reg_value[i]);
+  }
+}
+
+/**
+  @brief   Print the config space of every function that answers a vendor ID read,
+           in every ECAM region, as records that can be replayed without the hardware
+           by the simulated ECAM PAL in pal/sim. The snapshot is
+             ACSE <segment> <start bus> <end bus> <ecam base>   one per ECAM region
+             ACSC <bdf> <offset> <4 dwords>                      one per 16 bytes
+           Lines whose 4 dwords are all zero are left out, a replay reads them as 0.
+           Write masks are not probed, the replay derives RO, RW and RW1C bits from
+           the register layout unless ACSM records are added to the snapshot.
+  @param   None
+  @return  None
+**/
+static void
+val_pcie_dump_cfg_space(void)
+{
+  uint32_t i;
+  uint32_t seg, bus, dev, func;
+  uint32_t start_bus, end_bus;
+  uint32_t bdf;
+  uint32_t vendor_id;
+  uint32_t num_ecam;
+
+  num_ecam = (uint32_t)val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0);
+
+  for (i = 0; i < num_ecam; i++) {
+      val_print(ACS_PRINT_INFO, "\nACSE %x", val_pcie_get_info(PCIE_INFO_SEGMENT, i));
+      val_print(ACS_PRINT_INFO, " %x", val_pcie_get_info(PCIE_INFO_START_BUS, i));
+      val_print(ACS_PRINT_INFO, " %x", val_pcie_get_info(PCIE_INFO_END_BUS, i));
+      val_print(ACS_PRINT_INFO, " %llx", val_pcie_get_info(PCIE_INFO_ECAM, i));
+  }
+
+  for (i = 0; i < num_ecam; i++) {
+      seg = (uint32_t)val_pcie_get_info(PCIE_INFO_SEGMENT, i);
+      start_bus = (uint32_t)val_pcie_get_info(PCIE_INFO_START_BUS, i);
+      end_bus = (uint32_t)val_pcie_get_info(PCIE_INFO_END_BUS, i);
+
+      for (bus = start_bus; (bus <= end_bus) && (bus < PCIE_MAX_BUS); bus++) {
+          for (dev = 0; dev < PCIE_MAX_DEV; dev++) {
+              for (func = 0; func < PCIE_MAX_FUNC; func++) {
+                  bdf = PCIE_CREATE_BDF(seg, bus, dev, func);
+                  if (val_pcie_read_cfg(bdf, TYPE01_VIDR, &vendor_id))
+                      break;
+
+                  /* A device without function 0 implements no other function */
+                  if ((vendor_id & TYPE01_VIDR_MASK) == TYPE01_VIDR_MASK) {
+                      if (func == 0)
+                          break;
+                      continue;
+                  }
+
+                  val_pcie_dump_function(bdf);
+              }
+          }
+      }
+  }
+
+  val_print(ACS_PRINT_INFO, "\n", 0);
+}
+
 /**
   @brief   This API prints all the PCIe Devices info
            1. Caller       -  Validation layer.
@@ -429,6 +822,9 @@ val_pcie_print_device_info(void)
 
       ecam_index++;
   }
+
+  if (g_pcie_cfg_dump)
+      val_pcie_dump_cfg_space();
 }
 
 /**
@@ -454,6 +850,7 @@ val_pcie_create_info_table(uint64_t *pcie_info_table)
   g_pcie_info_table = (PCIE_INFO_TABLE *)pcie_info_table;
 
   pal_pcie_create_info_table(g_pcie_info_table);
+  val_pcie_create_ecam_lookup();
 
   num_ecam = (uint32_t)val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0);
   val_print(ACS_PRINT_TEST, " PCIE_INFO: Number of ECAM regions    :    %ld\n", num_ecam);
@@ -477,9 +874,21 @@ val_pcie_create_info_table(uint64_t *pcie_info_table)
   val_pcie_print_device_info();
 }
 
+/* Root port decoding each bus of one PCIe segment, see val_pcie_populate_device_rootport() */
+typedef struct {
+  uint32_t segment;
+  uint32_t rp_index[PCIE_MAX_BUS];   /* BDF table index + 1 of the root port, 0 if none */
+} PCIE_RP_LOOKUP;
+
 /**
   @brief  Sanity checks that all Endpoints must have a Rootport
 
+          Root ports and their secondary/subordinate bus ranges are collected
+          in one pass over the BDF table into a per segment bus lookup, so that
+          each function is resolved without rescanning the table. The first
+          root port in table order decoding a bus wins, as in
+          val_pcie_get_rootport.
+
   @param  None
   @return 0 if sanity check passes, 1 if sanity check fails
 **/
@@ -488,22 +897,234 @@ uint32_t val_pcie_populate_device_rootport(void)
   uint32_t bdf;
   uint32_t rp_bdf;
   uint32_t tbl_index;
+  uint32_t i, bus;
+  uint32_t seg_num;
+  uint32_t sec_bus;
+  uint32_t sub_bus;
+  uint32_t reg_value;
+  uint32_t dp_type;
+  uint32_t num_seg;
+  uint32_t max_seg;
+  uint32_t status;
+  uint8_t *resolved;
+  PCIE_RP_LOOKUP *rp_lookup;
+  PCIE_RP_LOOKUP *entry;
   pcie_device_bdf_table *bdf_tbl_ptr;
 
   bdf_tbl_ptr = val_pcie_bdf_table_ptr();
-  tbl_index = 0;
+  if (bdf_tbl_ptr->num_entries == 0)
+      return 0;
+
+  /* A segment can not hold root ports without an ECAM region */
+  max_seg = g_pcie_info_table->num_entries;
+  rp_lookup = val_memory_calloc(max_seg, sizeof(PCIE_RP_LOOKUP));
+  resolved = val_memory_calloc(bdf_tbl_ptr->num_entries, sizeof(uint8_t));
+
+  if ((rp_lookup == NULL) || (resolved == NULL)) {
+      val_print(ACS_PRINT_WARN, "\n       Rootport lookup allocation failed, scanning BDF table", 0);
+      if (rp_lookup != NULL)
+          val_memory_free(rp_lookup);
+      if (resolved != NULL)
+          val_memory_free(resolved);
+
+      status = 0;
+      for (tbl_index = 0; tbl_index < bdf_tbl_ptr->num_entries; tbl_index++)
+      {
+          bdf = bdf_tbl_ptr->device[tbl_index].bdf;
+          val_print(ACS_PRINT_DEBUG, "  Dev bdf 0x%06x", bdf);
+
+          /* Checks if the BDF has RootPort, RCiEP and RCEC have none by design */
+          if (val_pcie_get_rootport(bdf, &rp_bdf) && (rp_bdf != 0xffffffff))
+              status = 1;
 
+          bdf_tbl_ptr->device[tbl_index].rp_bdf = rp_bdf;
+          val_print(ACS_PRINT_DEBUG, " RP bdf 0x%06x\n", rp_bdf);
+      }
+      return status;
+  }
+
+  /* Pass 1 : resolve RP, iEP_RP, RCiEP and RCEC, collect root port bus ranges */
+  num_seg = 0;
+  for (tbl_index = 0; tbl_index < bdf_tbl_ptr->num_entries; tbl_index++)
+  {
+      bdf = bdf_tbl_ptr->device[tbl_index].bdf;
+      dp_type = val_pcie_device_port_type(bdf);
+
+      /* If the device is RP or iEP_RP, set its rootport value to same */
+      if ((dp_type == RP) || (dp_type == iEP_RP))
+      {
+          bdf_tbl_ptr->device[tbl_index].rp_bdf = bdf;
+          resolved[tbl_index] = 1;
+      }
+      /* If the device is RCiEP and RCEC, set RP as 0xff */
+      else if ((dp_type == RCiEP) || (dp_type == RCEC))
+      {
+          bdf_tbl_ptr->device[tbl_index].rp_bdf = 0xffffffff;
+          resolved[tbl_index] = 1;
+          continue;
+      }
+      else
+          continue;
+
+      seg_num = PCIE_EXTRACT_BDF_SEG(bdf);
+      for (i = 0; i < num_seg; i++) {
+          if (rp_lookup[i].segment == seg_num)
+              break;
+      }
+
+      if (i == num_seg) {
+          if (num_seg == max_seg)
+              continue;
+          rp_lookup[num_seg++].segment = seg_num;
+      }
+      entry = &rp_lookup[i];
+
+      val_pcie_read_cfg(bdf, TYPE1_PBN, &reg_value);
+      sec_bus = ((reg_value >> SECBN_SHIFT) & SECBN_MASK);
+      sub_bus = ((reg_value >> SUBBN_SHIFT) & SUBBN_MASK);
+      if (sub_bus >= PCIE_MAX_BUS)
+          sub_bus = PCIE_MAX_BUS - 1;
+
+      for (bus = sec_bus; bus <= sub_bus; bus++) {
+          if (entry->rp_index[bus] == 0)
+              entry->rp_index[bus] = tbl_index + 1;
+      }
+  }
+
+  /* Pass 2 : resolve every other function through its segment and bus */
+  status = 0;
   for (tbl_index = 0; tbl_index < bdf_tbl_ptr->num_entries; tbl_index++)
   {
       bdf = bdf_tbl_ptr->device[tbl_index].bdf;
       val_print(ACS_PRINT_DEBUG, "  Dev bdf 0x%06x", bdf);
 
-      /* Checks if the BDF has RootPort */
-      val_pcie_get_rootport(bdf, &rp_bdf);
+      if (resolved[tbl_index] == 0)
+      {
+          seg_num = PCIE_EXTRACT_BDF_SEG(bdf);
+          bus = PCIE_EXTRACT_BDF_BUS(bdf);
+          rp_bdf = 0;
+
+          for (i = 0; i < num_seg; i++) {
+              if ((rp_lookup[i].segment == seg_num) && (bus < PCIE_MAX_BUS) &&
+                  (rp_lookup[i].rp_index[bus] != 0)) {
+                  rp_bdf = bdf_tbl_ptr->device[rp_lookup[i].rp_index[bus] - 1].bdf;
+                  break;
+              }
+          }
+
+          if (i == num_seg) {
+              val_print(ACS_PRINT_ERR, "   PCIe Hierarchy fail: RP of bdf 0x%x not found\n", bdf);
+              status = 1;
+          }
+
+          bdf_tbl_ptr->device[tbl_index].rp_bdf = rp_bdf;
+      }
+
+      val_print(ACS_PRINT_DEBUG, " RP bdf 0x%06x\n", bdf_tbl_ptr->device[tbl_index].rp_bdf);
+  }
+
+  val_memory_free(rp_lookup);
+  val_memory_free(resolved);
+  return status;
+}
+
+/**
+  @brief   Append a function to the BDF table, doubling the table when it is full.
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return  0 if Success, 1 if the table could not grow
+**/
+static uint32_t
+val_pcie_bdf_table_add(uint32_t bdf)
+{
+  uint32_t size;
+  pcie_device_bdf_table *new_table;
+
+  if (g_pcie_bdf_table->num_entries == g_pcie_bdf_table_max) {
+      size = sizeof(pcie_device_bdf_table) + 2 * g_pcie_bdf_table_max * sizeof(pcie_device_attr);
+      new_table = (pcie_device_bdf_table *) pal_aligned_alloc(MEM_ALIGN_8K, size);
+      if (new_table == NULL) {
+          val_print(ACS_PRINT_ERR, "\n       PCIe BDF table full at %d entries",
+                    g_pcie_bdf_table->num_entries);
+          return 1;
+      }
 
-      bdf_tbl_ptr->device[tbl_index].rp_bdf = rp_bdf;
-      val_print(ACS_PRINT_DEBUG, " RP bdf 0x%06x\n", rp_bdf);
+      val_memcpy(new_table, g_pcie_bdf_table, sizeof(pcie_device_bdf_table) +
+                 g_pcie_bdf_table->num_entries * sizeof(pcie_device_attr));
+      pal_mem_free_aligned((void *)g_pcie_bdf_table);
+      g_pcie_bdf_table = new_table;
+      g_pcie_bdf_table_max = PCIE_BDF_TABLE_ENTRIES(size);
   }
+
+  g_pcie_bdf_table->device[g_pcie_bdf_table->num_entries].bdf = bdf;
+  g_pcie_bdf_table->device[g_pcie_bdf_table->num_entries].rp_bdf = 0;
+  g_pcie_bdf_table->num_entries++;
+  return 0;
+}
+
+/**
+  @brief   Sort the BDF table by BDF. Each ECAM region is enumerated in BDF order,
+           so only the entries of regions listed out of order are moved.
+  @param   None
+  @return  None
+**/
+static void
+val_pcie_sort_bdf_table(void)
+{
+  uint32_t i, j;
+  pcie_device_attr entry;
+
+  for (i = 1; i < g_pcie_bdf_table->num_entries; i++) {
+      entry = g_pcie_bdf_table->device[i];
+      for (j = i; (j > 0) && (g_pcie_bdf_table->device[j - 1].bdf > entry.bdf); j--)
+          g_pcie_bdf_table->device[j] = g_pcie_bdf_table->device[j - 1];
+      g_pcie_bdf_table->device[j] = entry;
+  }
+}
+
+/**
+  @brief   Return the index of the first BDF table entry not below a BDF.
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return  Index in g_pcie_bdf_table, num_entries if every entry is below bdf
+**/
+static uint32_t
+val_pcie_bdf_table_lower_bound(uint32_t bdf)
+{
+  uint32_t low = 0;
+  uint32_t high = g_pcie_bdf_table->num_entries;
+  uint32_t mid;
+
+  while (low < high) {
+      mid = low + (high - low) / 2;
+      if (g_pcie_bdf_table->device[mid].bdf < bdf)
+          low = mid + 1;
+      else
+          high = mid;
+  }
+
+  return low;
+}
+
+/**
+  @brief   Find a function in the BDF table.
+           1. Caller       -  Test Suite
+           2. Prerequisite -  val_pcie_create_device_bdf_table
+  @param   bdf   - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @param   index - Index of the function in the BDF table
+  @return  0 if the function is present, 1 otherwise
+**/
+uint32_t
+val_pcie_get_bdf_table_index(uint32_t bdf, uint32_t *index)
+{
+  uint32_t i;
+
+  if (g_pcie_bdf_table == NULL)
+      return 1;
+
+  i = val_pcie_bdf_table_lower_bound(bdf);
+  if ((i == g_pcie_bdf_table->num_entries) || (g_pcie_bdf_table->device[i].bdf != bdf))
+      return 1;
+
+  *index = i;
   return 0;
 }
 
@@ -532,6 +1153,12 @@ val_pcie_create_device_bdf_table()
   uint32_t p_cap;
   uint32_t status;
   uint32_t dp_type;
+  uint32_t header;
+  uint32_t sec_bus;
+  uint32_t sub_bus;
+  uint32_t single_func = 0;
+  uint32_t topology = (g_pcie_enum_mode == PCIE_ENUM_TOPOLOGY);
+  uint8_t  bus_reached[PCIE_MAX_BUS];
 
   /* if table is already present, return success */
   if (g_pcie_bdf_table)
@@ -548,6 +1175,7 @@ val_pcie_create_device_bdf_table()
   }
 
   g_pcie_bdf_table->num_entries = 0;
+  g_pcie_bdf_table_max = PCIE_BDF_TABLE_ENTRIES(PCIE_DEVICE_BDF_TABLE_SZ);
   g_pcie_integrated_devices = 0;
 
   num_ecam = (uint32_t)val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0);
@@ -564,9 +1192,17 @@ val_pcie_create_device_bdf_table()
       start_bus = (uint32_t)val_pcie_get_info(PCIE_INFO_START_BUS, ecam_index);
       end_bus = (uint32_t)val_pcie_get_info(PCIE_INFO_END_BUS, ecam_index);
 
+      /* In topology mode only the root bus and the buses behind the bridges found are scanned */
+      val_memory_set(bus_reached, sizeof(bus_reached), 0);
+      if (start_bus < PCIE_MAX_BUS)
+          bus_reached[start_bus] = 1;
+
       /* Iterate over all buses, devices and functions in this ecam */
       for (bus_index = start_bus; bus_index <= end_bus; bus_index++)
       {
+          if (topology && ((bus_index >= PCIE_MAX_BUS) || !bus_reached[bus_index]))
+              continue;
+
           if (pal_pcie_check_bus_valid(bus_index)) {
               val_print(ACS_PRINT_DEBUG,
                "       Bus 0x%x marked as invalid in Platform API...Skipping\n", bus_index);
@@ -577,6 +1213,9 @@ val_pcie_create_device_bdf_table()
           {
               for (func_index = 0; func_index < PCIE_MAX_FUNC; func_index++)
               {
+                  if (topology && (func_index != 0) && single_func)
+                      break;
+
                   /* Form bdf using seg, bus, device, function numbers */
                   bdf = PCIE_CREATE_BDF(seg_num, bus_index, dev_index, func_index);
 
@@ -588,9 +1227,34 @@ val_pcie_create_device_bdf_table()
                       return 1;
                   }
 
+                  /* Function 0 is implemented by every device, skip the others if it is absent */
+                  if (topology && (func_index == 0) && (reg_value == PCIE_UNKNOWN_RESPONSE))
+                      break;
+
                   /* Store the Function's BDF if there was a valid response */
                   if (reg_value != PCIE_UNKNOWN_RESPONSE)
                   {
+                      if (topology) {
+                          val_pcie_read_cfg(bdf, TYPE01_CLSR, &header);
+                          header = (header >> TYPE01_HTR_SHIFT) & TYPE01_HTR_MASK;
+
+                          /* Follow the bus range decoded by a bridge */
+                          if (((header >> HTR_HL_SHIFT) & HTR_HL_MASK) == TYPE1_HEADER) {
+                              val_pcie_read_cfg(bdf, TYPE1_PBN, &reg_value);
+                              sec_bus = (reg_value >> SECBN_SHIFT) & SECBN_MASK;
+                              sub_bus = (reg_value >> SUBBN_SHIFT) & SUBBN_MASK;
+                              for (; (sec_bus <= sub_bus) && (sec_bus <= end_bus) &&
+                                     (sec_bus < PCIE_MAX_BUS); sec_bus++) {
+                                  if (sec_bus > bus_index)
+                                      bus_reached[sec_bus] = 1;
+                              }
+                          }
+
+                          /* A single function device only implements function 0 */
+                          if (func_index == 0)
+                              single_func = !((header >> HTR_MFD_SHIFT) & HTR_MFD_MASK);
+                      }
+
                       /* Skip if the device is a host bridge */
                       if (val_pcie_is_host_bridge(bdf)) {
                           val_print(ACS_PRINT_DEBUG,
@@ -637,15 +1301,23 @@ val_pcie_create_device_bdf_table()
                       if ((dp_type == iEP_EP) || (dp_type == iEP_RP))
                           g_pcie_integrated_devices++;
 
-                      g_pcie_bdf_table->device[g_pcie_bdf_table->num_entries++].bdf = bdf;
+                      if (val_pcie_bdf_table_add(bdf))
+                          return 1;
                   }
               }
           }
       }
   }
 
+  /* Regions listed out of segment/bus order leave the table unsorted */
+  val_pcie_sort_bdf_table();
+
+  /* Cache the capability offsets of every function for val_pcie_find_capability */
+  val_pcie_create_cap_dir();
+
   /* Sanity Check : Confirm all EP (normal, integrated) have a rootport */
-  val_pcie_populate_device_rootport();
+  if (val_pcie_populate_device_rootport())
+      val_print(ACS_PRINT_ERR, "   PCIe Hierarchy fail: Functions without a rootport found\n", 0);
 
   val_print(ACS_PRINT_TEST,
     " PCIE_INFO: Number of BDFs found      :    %d\n", g_pcie_bdf_table->num_entries);
@@ -730,7 +1402,18 @@ val_pcie_bdf_table_ptr()
 void
 val_pcie_free_info_table(void)
 {
+    val_pcie_free_cap_dir();
+
+    if (g_pcie_ecam_lookup != NULL) {
+        val_memory_free(g_pcie_ecam_lookup);
+        g_pcie_ecam_lookup = NULL;
+        g_pcie_ecam_lookup_count = 0;
+    }
+
     if (g_pcie_info_table != NULL) {
+#ifndef TARGET_LINUX
+        pal_pcie_free_info_table();
+#endif
         pal_mem_free_aligned((void *)g_pcie_info_table);
         g_pcie_info_table = NULL;
     }
@@ -741,6 +1424,25 @@ val_pcie_free_info_table(void)
     }
 }
 
+/**
+  @brief  Returns the number of ECAM regions of the platform, before the
+          PCIe info table is created. The application sizes the table from it.
+          1. Caller       -  Application layer.
+
+  @param  None
+
+  @return Number of ECAM regions, 0 if unknown
+**/
+uint32_t
+val_pcie_get_num_ecam(void)
+{
+#ifndef TARGET_LINUX
+    return pal_pcie_get_num_ecam();
+#else
+    return 0;
+#endif
+}
+
 
 /**
   @brief   This API is the single entry point to return all PCIe related information
@@ -950,6 +1652,28 @@ val_pcie_find_capability(uint32_t bdf, uint32_t cid_type, uint32_t cid, uint32_t
   uint32_t reg_value;
   uint32_t next_cap_offset;
   uint32_t ret;
+  uint32_t i, first, num;
+  PCIE_CAP_DIR *dir;
+
+  dir = val_pcie_get_cap_dir(bdf);
+  if (dir != NULL) {
+      if (cid_type == PCIE_CAP) {
+          first = dir->first;
+          num = dir->num_cap;
+      } else if (cid_type == PCIE_ECAP) {
+          first = dir->first + dir->num_cap;
+          num = dir->num_ecap;
+      } else
+          return PCIE_CAP_NOT_FOUND;
+
+      for (i = first; i < (first + num); i++) {
+          if (g_pcie_cap_dir_entry[i].id == cid) {
+              *cid_offset = g_pcie_cap_dir_entry[i].offset;
+              return PCIE_SUCCESS;
+          }
+      }
+      return PCIE_CAP_NOT_FOUND;
+  }
 
   if (cid_type == PCIE_CAP) {
 
@@ -1369,9 +2093,298 @@ uint32_t val_pcie_bitfield_check(uint32_t bdf, uint64_t *bitfield_entry)
   return 0;
 }
 
+/* Bit-field entries of one table that target the same 32-bit config register */
+typedef struct {
+  uint32_t reg_type;
+  uint32_t id;                 /* cap_id or ecap_id, unused for HEADER */
+  uint32_t reg_offset;         /* Word aligned offset from the capability base */
+  uint32_t dev_port_bitmask;   /* Union of the bitmasks of the group's entries */
+  uint32_t first;              /* First index of the group in the entry order list */
+  uint32_t num;
+} PCIE_BF_GROUP;
+
+/**
+  @brief  Groups the entries of a bit-field table by register, keyed by register
+          type, capability id and word aligned offset. Entries keep their table
+          order within a group, and groups are ordered by their first entry.
+
+  @param  bf_table    - Bit-field table
+  @param  num_entries - Number of entries in the table
+  @param  group       - Group array, num_entries entries
+  @param  order       - Entry order list, num_entries entries
+  @return Number of groups
+**/
+static uint32_t
+val_pcie_bitfield_compile(pcie_cfgreg_bitfield_entry *bf_table, uint32_t num_entries,
+                          PCIE_BF_GROUP *group, uint32_t *order)
+{
+  uint32_t i, j, k;
+  uint32_t id;
+  uint32_t num_groups = 0;
+  uint32_t pos = 0;
+  pcie_cfgreg_bitfield_entry *bf_entry;
+
+  for (i = 0; i < num_entries; i++) {
+      bf_entry = &bf_table[i];
+      id = (bf_entry->reg_type == PCIE_CAP) ? bf_entry->cap_id :
+           (bf_entry->reg_type == PCIE_ECAP) ? bf_entry->ecap_id : 0;
+
+      for (j = 0; j < num_groups; j++) {
+          if ((group[j].reg_type == bf_entry->reg_type) && (group[j].id == id) &&
+              (group[j].reg_offset == (bf_entry->reg_offset & ~WORD_ALIGN_MASK)))
+              break;
+      }
+
+      if (j == num_groups) {
+          group[j].reg_type = bf_entry->reg_type;
+          group[j].id = id;
+          group[j].reg_offset = bf_entry->reg_offset & ~WORD_ALIGN_MASK;
+          num_groups++;
+      }
+      group[j].dev_port_bitmask |= bf_entry->dev_port_bitmask;
+      group[j].num++;
+  }
+
+  for (j = 0; j < num_groups; j++) {
+      group[j].first = pos;
+      pos += group[j].num;
+      group[j].num = 0;
+  }
+
+  for (i = 0; i < num_entries; i++) {
+      bf_entry = &bf_table[i];
+      id = (bf_entry->reg_type == PCIE_CAP) ? bf_entry->cap_id :
+           (bf_entry->reg_type == PCIE_ECAP) ? bf_entry->ecap_id : 0;
+
+      for (j = 0; j < num_groups; j++) {
+          if ((group[j].reg_type == bf_entry->reg_type) && (group[j].id == id) &&
+              (group[j].reg_offset == (bf_entry->reg_offset & ~WORD_ALIGN_MASK)))
+              break;
+      }
+
+      k = group[j].first + group[j].num++;
+      order[k] = i;
+  }
+
+  return num_groups;
+}
+
+/**
+  @brief  Checks all bit-fields of one register group of a function, see
+          val_pcie_bitfield_check for the per bit-field checks.
+
+          The register is read, written back to clear RW1C bits and read once
+          for the group. HW_INIT, READ_ONLY, STICKY_RO, RSVDP_RO and RSVDZ_RO
+          bit-fields are then checked together with one combined write and one
+          read-back, and each bit-field is judged on its own bits of the
+          read-back. READ_WRITE and STICKY_RW bit-fields are toggled one at a
+          time, since several of them flipped at once may have side effects.
+
+  @param  bdf      - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @param  dp_type  - Device/port type of the function
+  @param  bf_table - Bit-field table
+  @param  group    - Register group to check
+  @param  order    - Entry order list from val_pcie_bitfield_compile
+  @param  num_pass - Incremented for every bit-field that passes
+  @return Number of bit-fields that failed
+**/
+static uint32_t
+val_pcie_bitfield_group_check(uint32_t bdf, uint32_t dp_type,
+                              pcie_cfgreg_bitfield_entry *bf_table, PCIE_BF_GROUP *group,
+                              uint32_t *order, uint32_t *num_pass)
+{
+  uint32_t i;
+  uint32_t cap_base;
+  uint32_t bf_value;
+  uint32_t bf_mask;
+  uint32_t shft_cnt;
+  uint32_t reg_value;
+  uint32_t temp_reg_value;
+  uint32_t reg_overwrite_value;
+  uint32_t expected_value;
+  uint32_t ro_mask = 0;
+  uint32_t rsvdz_mask = 0;
+  uint32_t num_ro = 0;
+  uint32_t num_fails = 0;
+  uint32_t num_applicable = 0;
+  uint32_t status = PCIE_SUCCESS;
+  pcie_cfgreg_bitfield_entry *bf_entry;
+
+  if (!(dp_type & group->dev_port_bitmask))
+      return 0;
+
+  for (i = 0; i < group->num; i++) {
+      if (dp_type & bf_table[order[group->first + i]].dev_port_bitmask)
+          num_applicable++;
+  }
+
+  switch (group->reg_type)
+  {
+      case HEADER:
+          cap_base = 0;
+          break;
+      case PCIE_CAP:
+      case PCIE_ECAP:
+          status = val_pcie_find_capability(bdf, group->reg_type, group->id, &cap_base);
+          break;
+      default:
+          val_print(ACS_PRINT_ERR, "\n       Invalid reg_type : 0x%x  ", group->reg_type);
+          return num_applicable;
+  }
+
+  if (status != PCIE_SUCCESS)
+  {
+      val_print(ACS_PRINT_ERR, "\n       PCIe Capability 0x%x", group->id);
+      val_print(ACS_PRINT_ERR, " not found for BDF 0x%x", bdf);
+      return num_applicable;
+  }
+
+  /* Derive bit-fields of interest from the register value */
+  val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &reg_value);
+
+  /* To prevent status bits are clear when write 1, just clear it firstly */
+  val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_value);
+  val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &reg_value);
+
+  /* Check bit-field values, toggle RW bit-fields and collect the read-only ones */
+  for (i = 0; i < group->num; i++)
+  {
+      bf_entry = &bf_table[order[group->first + i]];
+      if (!(dp_type & bf_entry->dev_port_bitmask))
+          continue;
+
+      shft_cnt = REG_SHIFT(bf_entry->reg_offset & WORD_ALIGN_MASK, bf_entry->start);
+      bf_mask = REG_MASK(bf_entry->end, bf_entry->start) << shft_cnt;
+      bf_value = (reg_value & bf_mask) >> shft_cnt;
+
+      /* Check if bit-field value is proper */
+      if (bf_value != bf_entry->cfg_value)
+      {
+          val_print(ACS_PRINT_ERR, "\n       BDF 0x%x : ", bdf);
+          val_print(ACS_PRINT_ERR, bf_entry->err_str1, 0);
+          val_print(ACS_PRINT_ERR, ": 0x%x", bf_value);
+          val_print(ACS_PRINT_ERR, " instead of 0x%x", bf_entry->cfg_value);
+          if (!val_strncmp(bf_entry->err_str1, "WARNING", WARN_STR_LEN))
+              (*num_pass)++;
+          else
+              num_fails++;
+          continue;
+      }
+
+      switch (bf_entry->attr)
+      {
+          case HW_INIT:
+          case READ_ONLY:
+          case STICKY_RO:
+              /* Software must not alter these bits */
+              ro_mask |= bf_mask;
+              num_ro++;
+              continue;
+          case RSVDP_RO:
+              /* Software must preserve the value read to write to these bits */
+              num_ro++;
+              continue;
+          case RSVDZ_RO:
+              /* Software must use 0b to write to these bits */
+              rsvdz_mask |= bf_mask;
+              num_ro++;
+              continue;
+          case READ_WRITE:
+          case STICKY_RW:
+              /* Software can alter these bits, toggle the required bits and write to register */
+              reg_overwrite_value = reg_value ^ bf_mask;
+              val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_overwrite_value);
+              val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &temp_reg_value);
+              /* Restore the original register value */
+              val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_value);
+              break;
+          default:
+              val_print(ACS_PRINT_ERR, "\n       Invalid Attribute : 0x%x  ", bf_entry->attr);
+              num_fails++;
+              continue;
+      }
+
+      if (reg_overwrite_value != temp_reg_value)
+      {
+          val_print(ACS_PRINT_ERR, "\n       BDF 0x%x : ", bdf);
+          val_print(ACS_PRINT_ERR, bf_entry->err_str2, 0);
+          val_print(ACS_PRINT_ERR, ": 0x%x", reg_overwrite_value >> shft_cnt);
+          val_print(ACS_PRINT_ERR, " instead of 0x%x", temp_reg_value >> shft_cnt);
+          if (!val_strncmp(bf_entry->err_str2, "WARNING", WARN_STR_LEN))
+              (*num_pass)++;
+          else
+              num_fails++;
+          continue;
+      }
+
+      val_print(ACS_PRINT_INFO, "\n       BDF 0x%x : PASS", bdf);
+      (*num_pass)++;
+  }
+
+  if (num_ro == 0)
+      return num_fails;
+
+  /*
+   * One combined write for all read-only bit-fields : HW_INIT and RO ones
+   * toggled, RSVDZ ones zeroed and RSVDP ones written with the value read.
+   */
+  reg_overwrite_value = (reg_value ^ ro_mask) & ~rsvdz_mask;
+  val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_overwrite_value);
+  val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &temp_reg_value);
+
+  for (i = 0; i < group->num; i++)
+  {
+      bf_entry = &bf_table[order[group->first + i]];
+      if (!(dp_type & bf_entry->dev_port_bitmask))
+          continue;
+
+      if ((bf_entry->attr != HW_INIT) && (bf_entry->attr != READ_ONLY) &&
+          (bf_entry->attr != STICKY_RO) && (bf_entry->attr != RSVDP_RO) &&
+          (bf_entry->attr != RSVDZ_RO))
+          continue;
+
+      shft_cnt = REG_SHIFT(bf_entry->reg_offset & WORD_ALIGN_MASK, bf_entry->start);
+      bf_mask = REG_MASK(bf_entry->end, bf_entry->start) << shft_cnt;
+
+      /* Bit-fields with a wrong value were reported above */
+      if (((reg_value & bf_mask) >> shft_cnt) != bf_entry->cfg_value)
+          continue;
+
+      /* RSVDP bits must return 0 when read, the others must keep the value read */
+      expected_value = (bf_entry->attr == RSVDP_RO) ? 0 : (reg_value & bf_mask);
+
+      if ((temp_reg_value & bf_mask) != expected_value)
+      {
+          val_print(ACS_PRINT_ERR, "\n       BDF 0x%x : ", bdf);
+          val_print(ACS_PRINT_ERR, bf_entry->err_str2, 0);
+          val_print(ACS_PRINT_ERR, ": 0x%x", (temp_reg_value & bf_mask) >> shft_cnt);
+          val_print(ACS_PRINT_ERR, " instead of 0x%x", expected_value >> shft_cnt);
+          if (!val_strncmp(bf_entry->err_str2, "WARNING", WARN_STR_LEN))
+              (*num_pass)++;
+          else
+              num_fails++;
+          continue;
+      }
+
+      val_print(ACS_PRINT_INFO, "\n       BDF 0x%x : PASS", bdf);
+      (*num_pass)++;
+  }
+
+  /* Restore the register if a read-only bit-field took the written value */
+  if (temp_reg_value != reg_value)
+      val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_value);
+
+  return num_fails;
+}
+
 /**
   @brief  Returns if a PCIe config register bitfields are as per bsa specification.
 
+          The table is grouped by register once, see val_pcie_bitfield_compile,
+          and each group is checked with val_pcie_bitfield_group_check, so that
+          bit-fields of the same register share the capability lookup and the
+          config accesses.
+
   @param  bf_info_table - table of registers and their bit-fields for checking
   @param  num_bitfield_entries - Number of entries
   @return Return  0                 for success
@@ -1388,13 +2401,33 @@ val_pcie_register_bitfields_check(uint64_t *bf_info_table, uint32_t num_bitfield
   uint32_t num_fails;
   uint32_t num_pass;
   uint32_t index;
+  uint32_t num_groups;
+  uint32_t *order;
+  PCIE_BF_GROUP *group;
   pcie_cfgreg_bitfield_entry *bf_entry;
 
   num_fails = num_pass = tbl_index = 0;
+  dp_type = 0;
 
   val_print(ACS_PRINT_INFO, "\n       Number of bit-field entries to check %d",
             num_bitfield_entries);
 
+  group = val_memory_calloc(num_bitfield_entries, sizeof(PCIE_BF_GROUP));
+  order = val_memory_calloc(num_bitfield_entries, sizeof(uint32_t));
+  if ((group == NULL) || (order == NULL)) {
+      if (group != NULL)
+          val_memory_free(group);
+      if (order != NULL)
+          val_memory_free(order);
+      group = NULL;
+      order = NULL;
+  }
+
+  num_groups = 0;
+  if (group != NULL)
+      num_groups = val_pcie_bitfield_compile((pcie_cfgreg_bitfield_entry *)bf_info_table,
+                                             num_bitfield_entries, group, order);
+
   while (tbl_index < g_pcie_bdf_table->num_entries)
   {
       bdf = g_pcie_bdf_table->device[tbl_index++].bdf;
@@ -1405,7 +2438,15 @@ val_pcie_register_bitfields_check(uint64_t *bf_info_table, uint32_t num_bitfield
       /* Get the Function's device/port type from bdf */
       dp_type = val_pcie_device_port_type(bdf);
 
-      /* Set variables to iterate over all bit-field entries */
+      if (group != NULL) {
+          for (index = 0; index < num_groups; index++)
+              num_fails += val_pcie_bitfield_group_check(bdf, dp_type,
+                                             (pcie_cfgreg_bitfield_entry *)bf_info_table,
+                                             &group[index], order, &num_pass);
+          continue;
+      }
+
+      /* No memory for the groups, check one bit-field entry at a time */
       bf_entry = (pcie_cfgreg_bitfield_entry *)&(bf_info_table[0]);
 
       for (index = 0; index < num_bitfield_entries; index++)
@@ -1431,6 +2472,11 @@ val_pcie_register_bitfields_check(uint64_t *bf_info_table, uint32_t num_bitfield
       }
   }
 
+  if (group != NULL) {
+      val_memory_free(group);
+      val_memory_free(order);
+  }
+
   /* Return register check status */
   if (num_pass > 0 || num_fails > 0)
       return num_fails;
@@ -1589,23 +2635,23 @@ val_pcie_get_downstream_function(uint32_t bdf, uint32_t *dsf_bdf)
    * Bus number to the Subordinate Bus number, inclusive.
    *
    */
-  index = 0;
+  index = val_pcie_bdf_table_lower_bound(PCIE_CREATE_BDF(seg, sec_bus, 0, 0));
   while (index < g_pcie_bdf_table->num_entries)
   {
-      if (((PCIE_EXTRACT_BDF_BUS(g_pcie_bdf_table->device[index].bdf)) >= sec_bus) &&
-          ((PCIE_EXTRACT_BDF_BUS(g_pcie_bdf_table->device[index].bdf)) <= sub_bus) &&
-          ((PCIE_EXTRACT_BDF_SEG(g_pcie_bdf_table->device[index].bdf)) == seg))
-      {
-          *dsf_bdf = g_pcie_bdf_table->device[index].bdf;
+      /* The table is sorted by BDF, so the bus range ends at the first function past it */
+      if (((PCIE_EXTRACT_BDF_BUS(g_pcie_bdf_table->device[index].bdf)) > sub_bus) ||
+          ((PCIE_EXTRACT_BDF_SEG(g_pcie_bdf_table->device[index].bdf)) != seg))
+          break;
 
-          /* Return the bdf of first found type 0 function */
-          if (val_pcie_function_header_type(*dsf_bdf) == TYPE0_HEADER)
-              return 0;
-          else if (!type1_flag)
-          {
-              type1_flag++;
-              type1_bdf = *dsf_bdf;
-          }
+      *dsf_bdf = g_pcie_bdf_table->device[index].bdf;
+
+      /* Return the bdf of first found type 0 function */
+      if (val_pcie_function_header_type(*dsf_bdf) == TYPE0_HEADER)
+          return 0;
+      else if (!type1_flag)
+      {
+          type1_flag++;
+          type1_bdf = *dsf_bdf;
       }
 
       index++;
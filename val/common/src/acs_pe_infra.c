@@ -19,6 +19,9 @@
 #include "common/include/acs_pe.h"
 #include "common/include/acs_common.h"
 #include "common/include/acs_std_smc.h"
+#include "common/include/acs_memory.h"
+#include "common/include/acs_pgt.h"
+#include "common/include/acs_timer_support.h"
 #include "common/sys_arch_src/gic/acs_exception.h"
 #include "common/include/val_interface.h"
 #include "bsa/include/bsa_pal_interface.h"
@@ -41,6 +44,82 @@ ARM_SMC_ARGS g_smc_args;
 /* global variable to store primary PE index */
 uint32_t g_primary_pe_index = 0;
 
+/* Set when secondary PEs are kept resident in the worker pool between payloads */
+static uint32_t g_pe_pool_enable;
+
+/* Per PE flag of PSCI_CPU_ON calls still outstanding in val_execute_on_all_pe */
+static uint8_t *g_pe_launch_pending;
+
+/* MPIDR to PE index hash table, open addressed with linear probing */
+typedef struct {
+  uint64_t   mpidr;
+  uint32_t   pe_num;
+  uint32_t   valid;
+} PE_MPIDR_INDEX_ENTRY;
+
+static PE_MPIDR_INDEX_ENTRY *g_pe_mpidr_index;
+static uint32_t g_pe_mpidr_index_mask;
+
+/**
+  @brief   Hash the Aff3..Aff0 fields of an MPIDR into a slot of the
+           MPIDR index table.
+  @param   mpid - MPIDR affinity value
+  @return  Slot number in the MPIDR index table
+**/
+static uint32_t
+val_pe_mpidr_hash(uint64_t mpid)
+{
+  uint32_t aff;
+
+  aff = (uint32_t)(mpid & 0xFFFFFF) | (uint32_t)(((mpid >> 32) & 0xFF) << 24);
+
+  /* Fibonacci hashing spreads the densely packed affinity values */
+  return ((aff * 0x9E3779B1U) >> 8) & g_pe_mpidr_index_mask;
+}
+
+/**
+  @brief   Build the MPIDR to PE index hash table from g_pe_info_table, so
+           that val_pe_get_index_mpid does not need to scan every entry.
+           The table is cleaned to the point of coherency for the
+           secondary PEs.
+  @param   None
+  @return  None
+**/
+static void
+val_pe_create_mpidr_index(void)
+{
+  uint32_t i, slot, num_slots;
+  uint32_t num_pe = val_pe_get_num();
+  PE_INFO_ENTRY *entry = g_pe_info_table->pe_info;
+
+  /* Keep the load factor at or below one half */
+  num_slots = 1;
+  while (num_slots < (2 * num_pe))
+      num_slots <<= 1;
+
+  g_pe_mpidr_index = val_memory_calloc(num_slots, sizeof(PE_MPIDR_INDEX_ENTRY));
+  if (g_pe_mpidr_index == NULL) {
+      val_print(ACS_PRINT_WARN, " PE_INFO: MPIDR index allocation failed\n", 0);
+      return;
+  }
+  g_pe_mpidr_index_mask = num_slots - 1;
+
+  for (i = 0; i < num_pe; i++, entry++) {
+      slot = val_pe_mpidr_hash(entry->mpidr);
+      while (g_pe_mpidr_index[slot].valid)
+          slot = (slot + 1) & g_pe_mpidr_index_mask;
+
+      g_pe_mpidr_index[slot].mpidr = entry->mpidr;
+      g_pe_mpidr_index[slot].pe_num = entry->pe_num;
+      g_pe_mpidr_index[slot].valid = 1;
+  }
+
+  val_pe_cache_clean_range((uint64_t)g_pe_mpidr_index,
+                           (uint64_t)num_slots * sizeof(PE_MPIDR_INDEX_ENTRY));
+  val_data_cache_ops_by_va((addr_t)&g_pe_mpidr_index, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_pe_mpidr_index_mask, CLEAN_AND_INVALIDATE);
+}
+
 /**
   @brief   This API will call PAL layer to fill in the PE information
            into the g_pe_info_table pointer.
@@ -93,12 +172,20 @@ val_print(ACS_PRINT_TEST, " Primary PE: MIDR_EL1                 :    0x%llx \n"
                                                                      val_pe_reg_read(MIDR_EL1));
 #endif
 
+  val_pe_create_mpidr_index();
+
   /* store primary PE index for debug message printing purposes on
      multi PE tests */
   g_primary_pe_index = val_pe_get_index_mpid(val_pe_get_mpid());
   val_print(ACS_PRINT_DEBUG, " PE_INFO: Primary PE index       : %4d\n",
             g_primary_pe_index);
 
+  g_pe_launch_pending = val_memory_calloc(val_pe_get_num(), sizeof(uint8_t));
+
+#ifndef TARGET_LINUX
+  val_pgt_walk_cache_create(val_pe_get_num());
+#endif
+
   return ACS_STATUS_PASS;
 }
 
@@ -113,6 +200,20 @@ val_print(ACS_PRINT_TEST, " Primary PE: MIDR_EL1                 :    0x%llx \n"
 void
 val_pe_free_info_table(void)
 {
+    if (g_pe_mpidr_index != NULL) {
+        val_memory_free(g_pe_mpidr_index);
+        g_pe_mpidr_index = NULL;
+    }
+
+    if (g_pe_launch_pending != NULL) {
+        val_memory_free(g_pe_launch_pending);
+        g_pe_launch_pending = NULL;
+    }
+
+#ifndef TARGET_LINUX
+    val_pgt_walk_cache_free();
+#endif
+
     if (g_pe_info_table != NULL) {
         pal_mem_free_aligned((void *)g_pe_info_table);
         g_pe_info_table = NULL;
@@ -191,6 +292,8 @@ val_pe_get_mpid_index(uint32_t index)
 
 /**
   @brief   This API returns the index of the PE whose MPIDR matches with the input MPIDR
+           The MPIDR index table built with the PE info table answers in
+           constant time, the PE info table is scanned only as a fallback.
            1. Caller       -  Test Suite, VAL
            2. Prerequisite -  val_create_peinfo_table
   @param   mpid - the mpidr value of pE whose index is returned.
@@ -201,8 +304,28 @@ val_pe_get_index_mpid(uint64_t mpid)
 {
 
   PE_INFO_ENTRY *entry;
+  PE_MPIDR_INDEX_ENTRY *slot;
   uint32_t i = g_pe_info_table->header.num_of_pe;
 
+  if (g_pe_mpidr_index != NULL) {
+      slot = &g_pe_mpidr_index[val_pe_mpidr_hash(mpid)];
+
+      while (1) {
+        val_data_cache_ops_by_va((addr_t)slot, INVALIDATE);
+
+        if (!slot->valid)
+          return 0x0;  //Return index 0 as a safe failsafe value
+
+        if (slot->mpidr == mpid)
+          return slot->pe_num;
+
+        if (slot == &g_pe_mpidr_index[g_pe_mpidr_index_mask])
+          slot = g_pe_mpidr_index;
+        else
+          slot++;
+      }
+  }
+
   entry = g_pe_info_table->pe_info;
 
   while (i > 0) {
@@ -220,9 +343,86 @@ val_pe_get_index_mpid(uint64_t mpid)
 }
 
 
+/**
+  @brief   Undo the PE state a payload leaves behind which a PE powered on
+           with PSCI_CPU_ON would not have. The EL1 physical and virtual
+           timers, and the EL2 physical timer at EL2, are disabled and masked,
+           and VBAR_EL2 is restored to its value at power on.
+           Other system registers, GIC CPU interface and redistributor state
+           set up by a payload are kept, payloads run on pooled PEs must
+           restore them before returning, as they would before PSCI_CPU_OFF.
+           1. Caller       -  val_pe_pool_dispatch
+  @param   vbar - VBAR_EL2 of the PE at power on
+  @return  None
+**/
+static void
+val_pe_pool_reset_state(uint64_t vbar)
+{
+#ifndef TARGET_LINUX
+  ArmGenericTimerDisableTimer(CntpCtl);
+  ArmGenericTimerDisableTimer(CntvCtl);
+
+  if (val_pe_reg_read(CurrentEL) == AARCH64_EL2) {
+      ArmGenericTimerDisableTimer(CnthpCtl);
+      val_pe_reg_write(VBAR_EL2, vbar);
+  }
+#else
+  (void)vbar;
+#endif
+}
+
+/**
+  @brief   Dispatch loop for a secondary PE resident in the worker pool.
+           The PE sleeps in WFE until the primary PE posts a payload to its
+           mailbox, runs the payload and goes back to sleep. The state the
+           payload leaves behind is reset by val_pe_pool_reset_state.
+           1. Caller       -  val_test_entry
+           2. Prerequisite -  val_pe_pool_enable
+  @param   index - Index of this PE
+  @param   vbar - VBAR_EL2 of this PE at power on
+  @return  None, returns once the PE is asked to leave the pool
+**/
+static void
+val_pe_pool_dispatch(uint32_t index, uint64_t vbar)
+{
+  uint64_t test_arg;
+  uint32_t state;
+  void (*vector)(uint64_t args);
+#ifdef ACS_PROFILE
+  uint64_t start;
+#endif
+
+  /* The payload which parked the PE ran before the PE entered the pool */
+  val_pe_pool_reset_state(vbar);
+
+  while (1) {
+    val_set_pool_state(index, VAL_PE_POOL_IDLE);
+
+    while ((state = val_get_pool_state(index)) == VAL_PE_POOL_IDLE) {
+#ifndef TARGET_LINUX
+      ArmCallWFE();
+#endif
+    }
+
+    if (state != VAL_PE_POOL_RUN)
+      break;
+
+    val_get_test_data(index, (uint64_t *)&vector, &test_arg);
+#ifdef ACS_PROFILE
+    start = val_get_counter();
+#endif
+    vector(test_arg);
+    val_profile_pe_payload(index, start);
+    val_pe_pool_reset_state(vbar);
+  }
+
+  val_set_pool_state(index, VAL_PE_POOL_OFF);
+}
+
 /**
   @brief   'C' Entry point for Secondary PE.
-           Uses PSCI_CPU_OFF to switch off PE after payload execution.
+           Uses PSCI_CPU_OFF to switch off PE after payload execution, unless
+           the PE is to be kept resident in the worker pool.
            1. Caller       -  PAL code
            2. Prerequisite -  Stack pointer for this PE is setup by PAL
   @param   None
@@ -233,11 +433,28 @@ void
 val_test_entry(void)
 {
   uint64_t test_arg;
+  uint64_t vbar = 0;
+  uint32_t index;
   ARM_SMC_ARGS smc_args;
   void (*vector)(uint64_t args);
+#ifdef ACS_PROFILE
+  uint64_t start = val_get_counter();
+#endif
 
-  val_get_test_data(val_pe_get_index_mpid(val_pe_get_mpid()), (uint64_t *)&vector, &test_arg);
+#ifndef TARGET_LINUX
+  /* Restored between payloads if the PE parks in the worker pool */
+  if (val_pe_reg_read(CurrentEL) == AARCH64_EL2)
+      vbar = val_pe_reg_read(VBAR_EL2);
+#endif
+
+  index = val_pe_get_index_mpid(val_pe_get_mpid());
+  val_get_test_data(index, (uint64_t *)&vector, &test_arg);
   vector(test_arg);
+  val_profile_pe_payload(index, start);
+
+  /* Park in the worker pool instead of powering off, if asked by the primary PE */
+  if (val_get_pool_state(index) == VAL_PE_POOL_PARK)
+      val_pe_pool_dispatch(index, vbar);
 
   // We have completed our TEST code. So, switch off the PE now
   smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_OFF;
@@ -246,6 +463,61 @@ val_test_entry(void)
 }
 
 
+/**
+  @brief   Report the outcome of a PSCI_CPU_ON call and record a skip or
+           failure for the PE if it could not be powered on.
+  @param   index - Index of the PE which was woken up
+  @param   ret - PSCI return value of the CPU_ON call
+  @return  None
+**/
+static void
+val_pe_check_cpu_on(uint32_t index, uint64_t ret)
+{
+  if (ret == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON) {
+      val_print(ACS_PRINT_ERR, "\n       PSCI_CPU_ON: cpu already on", 0);
+      val_print(ACS_PRINT_WARN, "\n       WARNING: Skipping test for PE index %d "
+                              "since it is already on\n", index);
+
+      val_set_status(index, RESULT_SKIP(0, 0x120 - (int)ret));
+      return;
+  }
+  else {
+      if (ret == 0) {
+          val_print(ACS_PRINT_INFO, "\n       PSCI_CPU_ON: success", 0);
+          return;
+      }
+      else
+          val_print(ACS_PRINT_ERR, "\n       PSCI_CPU_ON: failure[%d]", ret);
+
+  }
+  val_set_status(index, RESULT_FAIL(0, 0x120 - (int)ret));
+}
+
+/**
+  @brief   Post the payload already in the mailbox of a PE parked in the worker
+           pool. A pooled PE can report its status, and release the primary PE,
+           before it is back in the dispatch loop, so callers retrying CPU_ON
+           check again here.
+  @param   index - Index of the PE
+  @param   wake - 1 to send the event which wakes the PE
+  @return  1 if the PE was idle in the pool and the payload is posted, else 0
+**/
+static uint32_t
+val_pe_pool_post(uint32_t index, uint32_t wake)
+{
+  if (val_get_pool_state(index) != VAL_PE_POOL_IDLE)
+      return 0;
+
+  val_set_pool_state(index, VAL_PE_POOL_RUN);
+#ifndef TARGET_LINUX
+  if (wake)
+      ArmCallSEV();
+#else
+  (void)wake;
+#endif
+  return 1;
+}
+
 /**
   @brief   This API initiates the execution of a test on a secondary PE.
            Uses PSCI_CPU_ON to wake a secondary PE
@@ -267,36 +539,165 @@ val_execute_on_pe(uint32_t index, void (*payload)(void), uint64_t test_input)
       return;
   }
 
+  /* Set the TEST function pointer in a shared memory location. This location is
+     read by the Secondary PE (val_test_entry()) and executes the test. */
+  val_set_test_data(index, (uint64_t)payload, test_input);
+
+  /* A PE still running a pooled payload parks itself again, leave its state alone */
+  if (val_get_pool_state(index) == VAL_PE_POOL_OFF)
+      val_set_pool_state(index, g_pe_pool_enable ? VAL_PE_POOL_PARK : VAL_PE_POOL_OFF);
+
   do {
-      g_smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_ON_AARCH64;
+      /* A PE parked in the worker pool only needs the payload posted to its mailbox.
+         A pooled PE stays on, CPU_ON fails until it is back in the dispatch loop */
+      if (val_pe_pool_post(index, 1))
+          return;
 
-      /* Set the TEST function pointer in a shared memory location. This location is
-         read by the Secondary PE (val_test_entry()) and executes the test. */
+      g_smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_ON_AARCH64;
       g_smc_args.Arg1 = val_pe_get_mpid_index(index);
-
-      val_set_test_data(index, (uint64_t)payload, test_input);
       pal_pe_execute_payload(&g_smc_args);
 
   } while (g_smc_args.Arg0 == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON && timeout--);
 
-  if (g_smc_args.Arg0 == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON) {
-      val_print(ACS_PRINT_ERR, "\n       PSCI_CPU_ON: cpu already on", 0);
-      val_print(ACS_PRINT_WARN, "\n       WARNING: Skipping test for PE index %d "
-                              "since it is already on\n", index);
+  val_pe_check_cpu_on(index, g_smc_args.Arg0);
+}
 
-      val_set_status(index, RESULT_SKIP(0, 0x120 - (int)g_smc_args.Arg0));
+/**
+  @brief   This API initiates the execution of a test on all secondary PEs
+           at once. The payload is posted to every PE mailbox first, parked
+           worker pool PEs are woken with a single event and the remaining
+           PEs are powered on back to back. PEs which are still on from a
+           previous payload are retried in later rounds rather than stalling
+           the launch of the others.
+           1. Caller       -  VAL, Test Suite
+           2. Prerequisite -  val_create_peinfo_table, val_allocate_shared_mem
+  @param   num_pe - Number of PEs, starting from index 0, to run the payload on
+  @param   payload - Function pointer of the test to be executed on the PEs
+  @param   test_input - arguments to be passed to the test.
+  @return  None
+**/
+void
+val_execute_on_all_pe(uint32_t num_pe, void (*payload)(void), uint64_t test_input)
+{
+  uint32_t i, pending, wake_pool;
+  uint32_t timeout = TIMEOUT_LARGE;
+  uint32_t my_index = val_pe_get_index_mpid(val_pe_get_mpid());
+
+  if (num_pe > val_pe_get_num())
+      num_pe = val_pe_get_num();
+
+  if (g_pe_launch_pending == NULL) {
+      for (i = 0; i < num_pe; i++) {
+          if (i != my_index)
+              val_execute_on_pe(i, payload, test_input);
+      }
       return;
   }
-  else {
-      if(g_smc_args.Arg0 == 0) {
-          val_print(ACS_PRINT_INFO, "\n       PSCI_CPU_ON: success", 0);
-          return;
+
+  /* Post the payload to every mailbox before waking up any PE */
+  pending = 0;
+  wake_pool = 0;
+  for (i = 0; i < num_pe; i++) {
+      g_pe_launch_pending[i] = 0;
+      if (i == my_index)
+          continue;
+
+      val_set_test_data(i, (uint64_t)payload, test_input);
+      if (val_pe_pool_post(i, 0)) {
+          wake_pool = 1;
+      } else {
+          if (val_get_pool_state(i) == VAL_PE_POOL_OFF)
+              val_set_pool_state(i, g_pe_pool_enable ? VAL_PE_POOL_PARK : VAL_PE_POOL_OFF);
+          g_pe_launch_pending[i] = 1;
+          pending++;
       }
-      else
-          val_print(ACS_PRINT_ERR, "\n       PSCI_CPU_ON: failure[%d]", g_smc_args.Arg0);
+  }
+
+#ifndef TARGET_LINUX
+  if (wake_pool)
+      ArmCallSEV();
+#else
+  (void)wake_pool;
+#endif
+
+  while (pending && timeout--) {
+      for (i = 0; i < num_pe; i++) {
+          if (!g_pe_launch_pending[i])
+              continue;
 
+          /* A pooled PE stays on, CPU_ON fails until it is back in the dispatch loop */
+          if (val_pe_pool_post(i, 1)) {
+              g_pe_launch_pending[i] = 0;
+              pending--;
+              continue;
+          }
+
+          g_smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_ON_AARCH64;
+          g_smc_args.Arg1 = val_pe_get_mpid_index(i);
+          pal_pe_execute_payload(&g_smc_args);
+
+          if (g_smc_args.Arg0 == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON)
+              continue;
+
+          g_pe_launch_pending[i] = 0;
+          pending--;
+          val_pe_check_cpu_on(i, g_smc_args.Arg0);
+      }
+  }
+
+  /* PEs still on after the timeout are skipped, as in val_execute_on_pe */
+  for (i = 0; i < num_pe; i++) {
+      if (g_pe_launch_pending[i])
+          val_pe_check_cpu_on(i, (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON);
   }
-  val_set_status(index, RESULT_FAIL(0, 0x120 - (int)g_smc_args.Arg0));
+}
+
+/**
+  @brief   This API enables or disables the worker pool. With the pool enabled,
+           secondary PEs are powered on once and stay parked in a WFE based
+           dispatch loop between payloads instead of being turned off with
+           PSCI_CPU_OFF. Disabling the pool powers off every parked PE so that
+           tests depending on PSCI_CPU_ON semantics see the legacy flow.
+           1. Caller       -  Application layer, Test Suite
+           2. Prerequisite -  val_allocate_shared_mem
+  @param   enable - 1 to keep secondary PEs resident, 0 to release them
+  @return  Previous state of the worker pool
+**/
+uint32_t
+val_pe_pool_enable(uint32_t enable)
+{
+  uint32_t i, state, timeout;
+  uint32_t num_pe;
+  uint32_t prev = g_pe_pool_enable;
+
+  g_pe_pool_enable = enable;
+
+  if (enable || !prev)
+      return prev;
+
+  num_pe = val_pe_get_num();
+
+  for (i = 0; i < num_pe; i++) {
+      timeout = TIMEOUT_LARGE;
+      while (--timeout) {
+          state = val_get_pool_state(i);
+          if (state == VAL_PE_POOL_OFF)
+              break;
+
+          /* PEs still running a payload are released once they park again */
+          if (state == VAL_PE_POOL_IDLE) {
+              val_set_pool_state(i, VAL_PE_POOL_EXIT);
+#ifndef TARGET_LINUX
+              ArmCallSEV();
+#endif
+          }
+      }
+
+      if (!timeout)
+          val_print(ACS_PRINT_WARN, "\n       PE index %d did not leave the worker pool", i);
+  }
+
+  return prev;
 }
 
 /**
@@ -386,6 +787,9 @@ void
 val_pe_default_esr(uint64_t interrupt_type, void *context)
 {
     uint32_t index = val_pe_get_index_mpid(val_pe_get_mpid());
+
+    /* Get the buffered log out before reporting the exception */
+    val_print_flush();
     val_print(ACS_PRINT_WARN, "\n        Unexpected exception of type %d occurred", interrupt_type);
 
 #ifndef TARGET_LINUX
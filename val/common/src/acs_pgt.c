@@ -1,5 +1,5 @@
 /** @file
- * Copyright (c) 2016-2019, 2023-2024, Arm Limited or its affiliates. All rights reserved.
+ * Copyright (c) 2016-2019, 2023-2025, Arm Limited or its affiliates. All rights reserved.
  * SPDX-License-Identifier : Apache-2.0
 
  * Licensed under the Apache License, Version 2.0 (the "License");
@@ -20,20 +20,13 @@
 
 #include "common/include/acs_pgt.h"
 #include "common/include/acs_memory.h"
-
-#define get_min(a, b) ((a) < (b))?(a):(b)
+#include "common/include/val_interface.h"
 
 #define PGT_DEBUG_LEVEL ACS_PRINT_INFO
 
-static uint32_t page_size;
-static uint32_t bits_per_level;
-static uint64_t pgt_addr_mask;
-uint64_t is_values_init = 0;
-uint64_t offset = 0;
-
 typedef struct
 {
-    uint64_t *tt_base;
+    uint64_t *tt_base;       /* NULL for a table not allocated yet during a dry run */
     uint64_t input_base;
     uint64_t input_top;
     uint64_t output_base;
@@ -42,186 +35,229 @@ typedef struct
     uint32_t nbits;
 } tt_descriptor_t;
 
-typedef struct {
-    uint32_t l0_index;
-    uint32_t l1_index;
-    uint32_t l2_index;
-    uint32_t l3_index;
-    uint64_t size_used;
-} acs_pgt_t;
-
-static acs_pgt_t acs_pgt_info;
+#define PGT_WALK_CACHE_WAYS 2
 
-void setup_acs_pgt_values(void)
+/* Software walk cache way, the last table reached at every lookup level of one
+   translation table, see val_pgt_walk */
+typedef struct
 {
-    acs_pgt_info.l0_index = 0;
-    acs_pgt_info.l1_index = 0;
-    acs_pgt_info.l2_index = 0;
-    acs_pgt_info.l3_index = 0;
-    acs_pgt_info.size_used = 0;
-}
+    uint64_t root;                    /* Physical base of the root table */
+    uint32_t ias;
+    uint32_t page_size_log2;
+    uint32_t valid;                   /* One bit per lookup level */
+    uint64_t tag[PGT_LEVEL_MAX];      /* VA bits above the range translated by the table */
+    uint64_t table[PGT_LEVEL_MAX];    /* Physical base of the table */
+} pgt_walk_cache_t;
+
+/* Walk cache of one PE */
+typedef struct
+{
+    pgt_walk_cache_t way[PGT_WALK_CACHE_WAYS];
+    uint32_t victim;                  /* Next way to replace, round robin */
+} pgt_walk_cache_set_t;
 
+static pgt_walk_cache_set_t *g_pgt_walk_cache;  /* One set per PE, NULL to walk uncached */
+static uint32_t g_pgt_walk_cache_num_pe;
 
-static
-uint32_t get_pgt_index(uint32_t level)
+/**
+  @brief  This API returns the log2(page_size)
+
+  @param  size   Size
+
+  @return log2 page size
+**/
+static uint32_t log2_page_size(uint64_t size)
 {
-    switch (level)
+    int bit = 0;
+    while (size != 0)
     {
-        case(PGT_LEVEL_0):
-            return acs_pgt_info.l0_index;
-        case(PGT_LEVEL_1):
-            return acs_pgt_info.l1_index;
-        case(PGT_LEVEL_2):
-            return acs_pgt_info.l2_index;
-        case(PGT_LEVEL_3):
-            return acs_pgt_info.l3_index;
-        default:
-            return 0;
+        if (size & 1)
+            return bit;
+        size >>= 1;
+        ++bit;
     }
+    return 0;
 }
 
-static
-void increment_pgt_index(uint32_t level, uint32_t max_index)
+/**
+  @brief  Initialise the granule dependent fields of a page table context
+
+  @param  ctx  Page table context
+  @param  ias  Input address size in bits
+
+  @return None
+**/
+static void pgt_ctx_setup(pgt_ctx_t *ctx, uint32_t ias)
 {
-    switch (level)
-    {
-        case(PGT_LEVEL_1):
-            if (acs_pgt_info.l1_index == (max_index - 1)) {
-                acs_pgt_info.l1_index = 0;
-                acs_pgt_info.l0_index++;
-            }
-            break;
+    ctx->page_size = val_memory_page_size();
+    ctx->page_size_log2 = log2_page_size(ctx->page_size);
+    ctx->bits_per_level = ctx->page_size_log2 - 3;
+    ctx->addr_mask = ((0x1ull << (ias - ctx->page_size_log2)) - 1) << ctx->page_size_log2;
+}
 
-        case(PGT_LEVEL_2):
-            if (acs_pgt_info.l2_index == (max_index - 1)) {
-                acs_pgt_info.l2_index = 0;
-                acs_pgt_info.l1_index++;
-            }
-            break;
+/**
+  @brief  Returns whether a block descriptor can be used at a lookup level. Without
+          FEAT_LPA2 and 52-bit addresses blocks exist at level 1 for the 4KB granule
+          and at level 2 for all granules.
 
-        case(PGT_LEVEL_3):
-            if (acs_pgt_info.l3_index == (max_index - 1)) {
-                acs_pgt_info.l3_index = 0;
-                acs_pgt_info.l2_index++;
-            } else
-                acs_pgt_info.l3_index++;
-            break;
-        default:
-            break;
-    }
+  @param  ctx    Page table context
+  @param  level  Lookup level
+
+  @return 1 if block descriptors are allowed
+**/
+static uint32_t pgt_block_allowed(pgt_ctx_t *ctx, uint32_t level)
+{
+    if (level == PGT_LEVEL_2)
+        return 1;
+
+    return ((level == PGT_LEVEL_1) && (ctx->page_size == PAGE_SIZE_4K));
 }
 
-static
-uint32_t get_entries_per_level(uint32_t page_size)
+/**
+  @brief  Get a zeroed translation table page, from the context pool if there is one.
+          A dry run only counts the page.
+
+  @param  ctx  Page table context
+
+  @return Table page, NULL for a dry run or on allocation failure
+**/
+static uint64_t *pgt_alloc_table(pgt_ctx_t *ctx)
 {
-    switch (page_size)
-    {
-        case(PAGE_SIZE_4K):   //4kb granule
-            return MAX_ENTRIES_4K;
-        case(PAGE_SIZE_16K):  //16kb granule
-            return MAX_ENTRIES_16K;
-        case(PAGE_SIZE_64K):  //64kb granule
-            return MAX_ENTRIES_64K;
-        default:
-            val_print(ACS_PRINT_ERR, "\n       %llx granularity not supported.", page_size);
-            return 0;
+    uint64_t *table;
+
+    if (ctx->dry_run) {
+        ctx->pages_used++;
+        return NULL;
+    }
+
+    if (ctx->pool != NULL) {
+        if (ctx->pages_used == ctx->pool_pages)
+            return NULL;
+        return (uint64_t *)((uint8_t *)ctx->pool + (uint64_t)ctx->page_size * ctx->pages_used++);
     }
+
+    table = val_memory_alloc_pages(1);
+    if (table == NULL)
+        return NULL;
+
+    val_memory_set(table, ctx->page_size, 0);
+    ctx->pages_used++;
+    return table;
 }
 
-static
-uint64_t get_block_size(uint32_t level)
+/**
+  @brief  Give back a table page taken by pgt_alloc_table. Pool pages are released
+          with the pool, see val_pgt_ctx_free.
+
+  @param  ctx    Page table context
+  @param  table  Table page
+
+  @return None
+**/
+static void pgt_free_table(pgt_ctx_t *ctx, uint64_t *table)
 {
-    uint32_t entries = get_entries_per_level(page_size);
-    switch (level)
-    {
-        case(PGT_LEVEL_0):  // For L0 table translation
-            if (page_size == PAGE_SIZE_4K)
-                return (uint64_t)(page_size * entries * entries * entries);
-            else if (page_size == PAGE_SIZE_16K)
-                return (uint64_t)(page_size * entries * entries * 2); // only 2 lookup tables in L0
-            else {
-                val_print(ACS_PRINT_ERR, "\n       L0 tables not supported for page size %llx",
-                                                                                        page_size);
-                return 0;
-            }
+    if (ctx->dry_run || (ctx->pool != NULL) || (table == NULL))
+        return;
+
+    val_memory_free_pages(table, 1);
+    ctx->pages_used--;
+}
+
+/**
+  @brief  Check whether a dry run has already counted the next level table of an entry.
+          The dry run has no tables to look at, so it replays what the earlier regions
+          of the walk left in the entry: the last earlier region reaching the entry
+          either maps all of it with a block, which replaces any table, or needs a table.
+
+  @param  ctx          Page table context
+  @param  mem_desc     Region being walked
+  @param  level        Lookup level of the entry
+  @param  entry_base   First input address translated through the entry
+  @param  block_size   Input address range of the entry
+
+  @return 1 if the table has been counted by an earlier region
+**/
+static uint32_t pgt_dry_run_table_counted(pgt_ctx_t *ctx, memory_region_descriptor_t *mem_desc,
+                                          uint32_t level, uint64_t entry_base,
+                                          uint64_t block_size)
+{
+    memory_region_descriptor_t *prev = mem_desc;
+    uint64_t entry_top = entry_base + block_size - 1;
+    uint64_t lo, hi;
+
+    while (prev != ctx->regions) {
+        prev--;
+        lo = prev->virtual_address;
+        hi = prev->virtual_address + prev->length - 1;
+        if (hi < entry_base || lo > entry_top)
+            continue;
 
-        case(PGT_LEVEL_1):  // For L1 table translation
-            if (page_size == PAGE_SIZE_4K || page_size == PAGE_SIZE_16K)
-                return (uint64_t)(page_size * entries * entries);
-            else
-                return (uint64_t)(page_size * entries * 64); // 64 Lookup tables in L1 (64KB Gran)
-
-        case(PGT_LEVEL_2):  // For L2 table translation
-            return (uint64_t)(page_size * entries);
-        case(PGT_LEVEL_3):  // For L3 table translation
-            return (uint64_t)(page_size);
-        default:
+        lo = (lo > entry_base) ? lo : entry_base;
+        hi = (hi < entry_top) ? hi : entry_top;
+        if (pgt_block_allowed(ctx, level) && lo == entry_base && hi == entry_top &&
+            ((prev->physical_address + (lo - prev->virtual_address)) & (block_size - 1)) == 0)
             return 0;
+
+        return 1;
     }
+
+    return 0;
 }
 
 /**
   @brief  This API fills the translation table
 
+  @param  ctx       Page table context
   @param  tt_desc   Translation Table Descriptor
   @param  mem_desc  Memory Descriptor
 
   @return 0 if Success
 **/
 static
-uint32_t fill_translation_table(tt_descriptor_t tt_desc, memory_region_descriptor_t *mem_desc)
+uint32_t fill_translation_table(pgt_ctx_t *ctx, tt_descriptor_t tt_desc,
+                                memory_region_descriptor_t *mem_desc)
 {
     uint64_t block_size = 0x1ull << tt_desc.size_log2;
-    uint64_t input_address, output_address, filled_tables, table_index, max_allowed_mem;
+    uint64_t input_address, output_address, entry_top, table_index, desc;
     uint64_t *tt_base_next_level, *table_desc;
+    uint32_t new_table;
     tt_descriptor_t tt_desc_next_level;
 
-    val_print(PGT_DEBUG_LEVEL, "\n       tt_desc.level: %d     ", tt_desc.level);
-    val_print(PGT_DEBUG_LEVEL, "\n       tt_desc.input_base: 0x%llx     ", tt_desc.input_base);
-    val_print(PGT_DEBUG_LEVEL, "\n       tt_desc.input_top: 0x%llx     ", tt_desc.input_top);
-    val_print(PGT_DEBUG_LEVEL, "\n       tt_desc.output_base: 0x%llx     ", tt_desc.output_base);
-    val_print(PGT_DEBUG_LEVEL, "\n       tt_desc.size_log2: %d     ", tt_desc.size_log2);
-    val_print(PGT_DEBUG_LEVEL, "\n       tt_desc.nbits: %d     ", tt_desc.nbits);
-
-    if (!is_values_init) {
-        setup_acs_pgt_values();
-        is_values_init = 1;
-    }
-
     for (input_address = tt_desc.input_base, output_address = tt_desc.output_base;
-         input_address < tt_desc.input_top;
-         input_address += (block_size - offset), output_address += (block_size - offset))
+         input_address <= tt_desc.input_top;
+         output_address += entry_top - input_address + 1, input_address = entry_top + 1)
     {
-        table_index = input_address >> tt_desc.size_log2 & ((0x1ull << tt_desc.nbits) - 1);
-        table_desc = &tt_desc.tt_base[table_index];
+        /* Last input address translated through this entry */
+        entry_top = input_address | (block_size - 1);
+        if (entry_top > tt_desc.input_top)
+            entry_top = tt_desc.input_top;
 
-        val_print(PGT_DEBUG_LEVEL, "\n       table_index = %d     ", table_index);
+        table_index = input_address >> tt_desc.size_log2 & ((0x1ull << tt_desc.nbits) - 1);
+        table_desc = (tt_desc.tt_base != NULL) ? &tt_desc.tt_base[table_index] : NULL;
+        desc = (table_desc != NULL) ? *table_desc : 0;
 
         if (tt_desc.level == 3)
         {
             //Create level 3 page descriptor entry
+            if (ctx->dry_run)
+                continue;
             *table_desc = PGT_ENTRY_PAGE_MASK | PGT_ENTRY_VALID_MASK;
-            *table_desc |= (output_address & ~(uint64_t)(page_size - 1));
+            *table_desc |= (output_address & ~(uint64_t)(ctx->page_size - 1));
             *table_desc |= mem_desc->attributes;
-            val_print(PGT_DEBUG_LEVEL, "\n       page_descriptor = 0x%llx     ", *table_desc);
-            /* Keep a count of number of L3 tables filled. If the number exceedes the limit, move
-               to next L2 table and continue.  */
-            increment_pgt_index(tt_desc.level, get_entries_per_level(page_size));
-            offset = 0;
             continue;
         }
 
         //Are input and output addresses eligible for being described via block descriptor?
-        if ((input_address & (block_size - 1)) == 0 &&
-             (output_address & (block_size - 1)) == 0 &&
-             tt_desc.input_top >= (input_address + block_size - 1)) {
+        if (pgt_block_allowed(ctx, tt_desc.level) &&
+            (input_address & (block_size - 1)) == 0 &&
+            (output_address & (block_size - 1)) == 0 &&
+            (entry_top - input_address) == (block_size - 1)) {
             //Create a block descriptor entry
+            if (ctx->dry_run)
+                continue;
             *table_desc = PGT_ENTRY_BLOCK_MASK | PGT_ENTRY_VALID_MASK;
             *table_desc |= (output_address & ~(block_size - 1));
             *table_desc |= mem_desc->attributes;
-            val_print(PGT_DEBUG_LEVEL, "\n       block_descriptor = 0x%llx     ", *table_desc);
-            increment_pgt_index(tt_desc.level, get_entries_per_level(page_size));
-            offset = 0;
             continue;
         }
         /*
@@ -229,242 +265,442 @@ uint32_t fill_translation_table(tt_descriptor_t tt_desc, memory_region_descripto
         If there's a block descriptor, allocate new page, else use the already populated address.
         Block descriptor info will be overwritten in case its there.
         */
-        if (*table_desc == 0 || IS_PGT_ENTRY_BLOCK(*table_desc))
+        new_table = (desc == 0 || IS_PGT_ENTRY_BLOCK(desc));
+        if (new_table && ctx->dry_run &&
+            pgt_dry_run_table_counted(ctx, mem_desc, tt_desc.level,
+                                      input_address & ~(block_size - 1), block_size))
+            new_table = 0;
+
+        if (new_table)
         {
-            tt_base_next_level = val_memory_alloc_pages(1);
-            if (tt_base_next_level == NULL)
+            tt_base_next_level = pgt_alloc_table(ctx);
+            if (tt_base_next_level == NULL && !ctx->dry_run)
             {
                 val_print(ACS_PRINT_ERR,
                 "\n       fill_translation_table: page allocation failed     ",
                 0);
                 return ACS_STATUS_ERR;
             }
-            val_memory_set(tt_base_next_level, page_size, 0);
         }
+        else if (ctx->dry_run)
+            tt_base_next_level = NULL;
         else
-            tt_base_next_level = val_memory_phys_to_virt(*table_desc & pgt_addr_mask);
-
-        tt_desc_next_level.tt_base    = tt_base_next_level;
-        tt_desc_next_level.input_base = input_address;
-        filled_tables                 = get_pgt_index(tt_desc.level + 1);
-        offset                        = filled_tables * get_block_size(tt_desc.level + 1);
+            tt_base_next_level = val_memory_phys_to_virt(desc & ctx->addr_mask);
 
-        val_print(PGT_DEBUG_LEVEL, "       filled_tables in next level = 0x%llx", filled_tables);
-        val_print(PGT_DEBUG_LEVEL, "       offset = 0x%llx", offset);
-
-        // Calculate the maximum allowed mem addr that can be mapped for the L0/L1/L2 table.
-        // This prevents overwriting page tables.
-        max_allowed_mem                = input_address + block_size - offset - 1;
-        tt_desc_next_level.input_top   = get_min(tt_desc.input_top, max_allowed_mem);
+        tt_desc_next_level.tt_base     = tt_base_next_level;
+        tt_desc_next_level.input_base  = input_address;
+        tt_desc_next_level.input_top   = entry_top;
         tt_desc_next_level.output_base = output_address;
         tt_desc_next_level.level       = tt_desc.level + 1;
-        tt_desc_next_level.size_log2   = tt_desc.size_log2 - bits_per_level;
-        tt_desc_next_level.nbits       = bits_per_level;
-        increment_pgt_index(tt_desc.level, get_entries_per_level(page_size));
+        tt_desc_next_level.size_log2   = tt_desc.size_log2 - ctx->bits_per_level;
+        tt_desc_next_level.nbits       = ctx->bits_per_level;
 
-        if (fill_translation_table(tt_desc_next_level, mem_desc))
+        if (fill_translation_table(ctx, tt_desc_next_level, mem_desc))
         {
-            val_memory_free_pages(tt_base_next_level, 1);
+            if (new_table)
+                pgt_free_table(ctx, tt_base_next_level);
             return ACS_STATUS_ERR;
         }
 
+        if (ctx->dry_run)
+            continue;
+
         *table_desc = PGT_ENTRY_TABLE_MASK | PGT_ENTRY_VALID_MASK;
         *table_desc |= (uint64_t)val_memory_virt_to_phys(tt_base_next_level) &
-                       ~(uint64_t)(page_size - 1);
-        val_print(PGT_DEBUG_LEVEL, "\n      table_descriptor = 0x%llx     ", *table_desc);
+                       ~(uint64_t)(ctx->page_size - 1);
     }
     return 0;
 }
 
 /**
-  @brief  This API returns the log2(page_size)
-
-  @param  size   Size
-
-  @return log2 page size
-**/
-static uint32_t log2_page_size(uint64_t size)
-{
-    int bit = 0;
-    while (size != 0)
-    {
-        if (size & 1)
-            return bit;
-        size >>= 1;
-        ++bit;
-    }
-    return 0;
-}
-
-/**
-  @brief Create stage 1 or stage 2 page table, with given memory addresses and attributes
-         Note: This API updates existing translation table if pgt_desc->pgt_base is not NULL
-               else it created new table and updated pgt_desc->pgt_base with the address.
+  @brief Create or update a stage 1 or stage 2 page table through a page table context.
+         The context holds all state of the walk, so that tables can be built
+         concurrently by different callers.
+  @param ctx - Page table context, its pool and dry_run fields are set by the caller.
   @param mem_desc - Array of memory addresses and attributes needed for page table creation.
   @param pgt_desc - Data structure for output page table base and input translation attributes.
   @return status
 **/
-uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc)
+static
+uint32_t pgt_create(pgt_ctx_t *ctx, memory_region_descriptor_t *mem_desc,
+                    pgt_descriptor_t *pgt_desc)
 {
     uint64_t *tt_base;
     tt_descriptor_t tt_desc;
-    uint32_t num_pgt_levels, page_size_log2;
+    uint32_t num_pgt_levels;
     memory_region_descriptor_t *mem_desc_iter;
 
-    page_size = val_memory_page_size();
-    page_size_log2 = log2_page_size(page_size);
-    bits_per_level = page_size_log2 - 3;
-    num_pgt_levels = (pgt_desc->ias - page_size_log2 + bits_per_level - 1)/bits_per_level;
+    pgt_ctx_setup(ctx, pgt_desc->ias);
+    num_pgt_levels = (pgt_desc->ias - ctx->page_size_log2 + ctx->bits_per_level - 1) /
+                     ctx->bits_per_level;
     num_pgt_levels = (num_pgt_levels > 4)?4:num_pgt_levels;
-    val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_create: nbits_per_level = %d    ", bits_per_level);
-    val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_create: page_size_log2 = %d     ", page_size_log2);
+    val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_create: nbits_per_level = %d    ",
+              ctx->bits_per_level);
+    val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_create: page_size_log2 = %d     ",
+              ctx->page_size_log2);
 
     /* check whether input page descriptor has base addr of translation table
        to use. If the pgt_base member is NULL allocate a page to create a new
        table, else update existing translation table */
     if (pgt_desc->pgt_base == (uint64_t) NULL) {
-        tt_base = (uint64_t *) val_memory_alloc_pages(1);
-        if (tt_base == NULL) {
+        tt_base = pgt_alloc_table(ctx);
+        if (tt_base == NULL && !ctx->dry_run) {
             val_print(ACS_PRINT_ERR, "\n      val_pgt_create: page allocation failed     ", 0);
             return ACS_STATUS_ERR;
         }
-        val_memory_set(tt_base, page_size, 0);
     }
     else
         tt_base = (uint64_t *) pgt_desc->pgt_base;
 
     tt_desc.tt_base = tt_base;
-    pgt_addr_mask = ((0x1ull << (pgt_desc->ias - page_size_log2)) - 1) << page_size_log2;
+    ctx->regions = mem_desc;
 
     for (mem_desc_iter = mem_desc; mem_desc_iter->length != 0; ++mem_desc_iter)
     {
         val_print(PGT_DEBUG_LEVEL,
                   "      val_pgt_create: input addr = 0x%x     ",
-                  mem_desc->virtual_address);
+                  mem_desc_iter->virtual_address);
         val_print(PGT_DEBUG_LEVEL,
                   "      val_pgt_create: output addr = 0x%x     ",
-                  mem_desc->physical_address);
-        val_print(PGT_DEBUG_LEVEL, "      val_pgt_create: length = 0x%x\n     ", mem_desc->length);
-        if ((mem_desc->virtual_address & (uint64_t)(page_size - 1)) != 0 ||
-            (mem_desc->physical_address & (uint64_t)(page_size - 1)) != 0)
+                  mem_desc_iter->physical_address);
+        val_print(PGT_DEBUG_LEVEL, "      val_pgt_create: length = 0x%x\n     ",
+                  mem_desc_iter->length);
+        if ((mem_desc_iter->virtual_address & (uint64_t)(ctx->page_size - 1)) != 0 ||
+            (mem_desc_iter->physical_address & (uint64_t)(ctx->page_size - 1)) != 0)
             {
                 val_print(ACS_PRINT_ERR, "\n       val_pgt_create: addr alignment err     ", 0);
-                return ACS_STATUS_ERR;
+                goto error;
             }
 
-        if (mem_desc->physical_address >= (0x1ull << pgt_desc->oas))
+        if (mem_desc_iter->physical_address >= (0x1ull << pgt_desc->oas))
         {
             val_print(ACS_PRINT_ERR,
                       "\n       val_pgt_create: output address size error     ",
                       0);
-            return ACS_STATUS_ERR;
+            goto error;
         }
 
-        if (mem_desc->virtual_address >= (0x1ull << pgt_desc->ias))
+        if (mem_desc_iter->virtual_address >= (0x1ull << pgt_desc->ias))
         {
             val_print(ACS_PRINT_WARN,
                       "\n       val_pgt_create: input address size error, "
                       "truncating to %d-bits     ",
                       pgt_desc->ias);
-            mem_desc->virtual_address &= ((0x1ull << pgt_desc->ias) - 1);
+            mem_desc_iter->virtual_address &= ((0x1ull << pgt_desc->ias) - 1);
         }
 
-        tt_desc.input_base = mem_desc->virtual_address & ((0x1ull << pgt_desc->ias) - 1);
-        tt_desc.input_top = tt_desc.input_base + mem_desc->length - 1;
-        tt_desc.output_base = mem_desc->physical_address & ((0x1ull << pgt_desc->oas) - 1);
+        tt_desc.input_base = mem_desc_iter->virtual_address & ((0x1ull << pgt_desc->ias) - 1);
+        tt_desc.input_top = tt_desc.input_base + mem_desc_iter->length - 1;
+        tt_desc.output_base = mem_desc_iter->physical_address & ((0x1ull << pgt_desc->oas) - 1);
         tt_desc.level = 4 - num_pgt_levels;
-        tt_desc.size_log2 = (num_pgt_levels - 1) * bits_per_level + page_size_log2;
+        tt_desc.size_log2 = (num_pgt_levels - 1) * ctx->bits_per_level + ctx->page_size_log2;
         tt_desc.nbits = pgt_desc->ias - tt_desc.size_log2;
 
-        if (fill_translation_table(tt_desc, mem_desc))
-        {
-            val_memory_free_pages(tt_base, 1);
-            return ACS_STATUS_ERR;
-        }
+        if (fill_translation_table(ctx, tt_desc, mem_desc_iter))
+            goto error;
     }
 
-    pgt_desc->pgt_base = (uint64_t)val_memory_virt_to_phys(tt_base);
+    if (!ctx->dry_run)
+        pgt_desc->pgt_base = (uint64_t)val_memory_virt_to_phys(tt_base);
 
     return 0;
+
+error:
+    if (pgt_desc->pgt_base == (uint64_t) NULL)
+        pgt_free_table(ctx, tt_base);
+    return ACS_STATUS_ERR;
 }
 
 /**
-  @brief Get attributes of a page corresponding to a given virtual address.
-  @param pgt_desc - page table base and translation attributes.
-  @param virtual_address - virtual address of memory region base whose attribute is to be read.
-  @param attributes - output attributes
+  @brief Create stage 1 or stage 2 page table, with given memory addresses and attributes
+         Note: This API updates existing translation table if pgt_desc->pgt_base is not NULL
+               else it created new table and updated pgt_desc->pgt_base with the address.
+               Table pages are allocated one at a time, free them with val_pgt_destroy.
+  @param mem_desc - Array of memory addresses and attributes needed for page table creation.
+  @param pgt_desc - Data structure for output page table base and input translation attributes.
   @return status
 **/
-uint64_t val_pgt_get_attributes(pgt_descriptor_t pgt_desc, uint64_t virtual_address,
-                                uint64_t *attributes)
+uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc)
 {
-    uint32_t ias, index, num_pgt_levels, this_level;
-    uint32_t bits_at_this_level, bits_remaining;
-    uint64_t val64, tt_base_phys, *tt_base_virt;
-    uint32_t page_size_log2 = pgt_desc.tcr.tg_size_log2;
+    pgt_ctx_t ctx;
 
-    if (attributes == NULL)
+    val_pgt_walk_cache_invalidate();
+    val_memory_set(&ctx, sizeof(ctx), 0);
+    return pgt_create(&ctx, mem_desc, pgt_desc);
+}
+
+/**
+  @brief Create a new stage 1 or stage 2 page table with all table pages taken from one
+         contiguous pool. A dry run over mem_desc sizes the pool first.
+         Note: pgt_desc->pgt_base must be NULL. The table is freed with val_pgt_ctx_free,
+               not with val_pgt_destroy.
+  @param ctx - Page table context owned by the caller, reports the table pages used.
+  @param mem_desc - Array of memory addresses and attributes needed for page table creation.
+  @param pgt_desc - Data structure for output page table base and input translation attributes.
+  @return status
+**/
+uint32_t val_pgt_ctx_create(pgt_ctx_t *ctx, memory_region_descriptor_t *mem_desc,
+                            pgt_descriptor_t *pgt_desc)
+{
+    if (pgt_desc->pgt_base != (uint64_t) NULL) {
+        val_print(ACS_PRINT_ERR, "\n       val_pgt_ctx_create: pgt_base must be NULL     ", 0);
         return ACS_STATUS_ERR;
+    }
 
-    if (!pgt_desc.pgt_base)
+    val_pgt_walk_cache_invalidate();
+    val_memory_set(ctx, sizeof(pgt_ctx_t), 0);
+
+    /* Dry run to count the table pages of the mapping */
+    ctx->dry_run = 1;
+    if (pgt_create(ctx, mem_desc, pgt_desc))
         return ACS_STATUS_ERR;
 
-    ias = (uint32_t)64 - pgt_desc.tcr.tsz;
+    ctx->dry_run = 0;
+    ctx->pool_pages = ctx->pages_used;
+    ctx->pages_used = 0;
+    val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_ctx_create: table pages = %d     ",
+              ctx->pool_pages);
+
+    ctx->pool = val_memory_alloc_pages(ctx->pool_pages);
+    if (ctx->pool == NULL) {
+        val_print(ACS_PRINT_ERR, "\n       val_pgt_ctx_create: pool allocation failed     ", 0);
+        return ACS_STATUS_ERR;
+    }
+    val_memory_set(ctx->pool, ctx->pool_pages * ctx->page_size, 0);
+
+    if (pgt_create(ctx, mem_desc, pgt_desc)) {
+        val_pgt_ctx_free(ctx);
+        pgt_desc->pgt_base = (uint64_t) NULL;
+        return ACS_STATUS_ERR;
+    }
+
+    return 0;
+}
+
+/**
+  @brief Free the table page pool of a page table built by val_pgt_ctx_create.
+  @param ctx - Page table context
+  @return void
+**/
+void val_pgt_ctx_free(pgt_ctx_t *ctx)
+{
+    if (ctx->pool == NULL)
+        return;
+
+    val_pgt_walk_cache_invalidate();
+    val_memory_free_pages(ctx->pool, ctx->pool_pages);
+    ctx->pool = NULL;
+    ctx->pool_pages = 0;
+    ctx->pages_used = 0;
+}
+
+/**
+  @brief Allocate the software walk cache, one set per PE. Until it exists, and after
+         val_pgt_walk_cache_free, val_pgt_walk walks from the root table every time.
+  @param num_pe - Number of PEs.
+  @return void
+**/
+void val_pgt_walk_cache_create(uint32_t num_pe)
+{
+    g_pgt_walk_cache = val_memory_calloc(num_pe, sizeof(pgt_walk_cache_set_t));
+    g_pgt_walk_cache_num_pe = (g_pgt_walk_cache != NULL) ? num_pe : 0;
+}
+
+/**
+  @brief Free the software walk cache.
+  @return void
+**/
+void val_pgt_walk_cache_free(void)
+{
+    if (g_pgt_walk_cache == NULL)
+        return;
+
+    val_memory_free(g_pgt_walk_cache);
+    g_pgt_walk_cache = NULL;
+    g_pgt_walk_cache_num_pe = 0;
+}
+
+/**
+  @brief Invalidate the software walk cache of every PE. Called by every API of this
+         file that changes translation tables, and needed after any other table update.
+  @return void
+**/
+void val_pgt_walk_cache_invalidate(void)
+{
+    uint32_t pe_index, way;
+
+    if (g_pgt_walk_cache == NULL)
+        return;
+
+    for (pe_index = 0; pe_index < g_pgt_walk_cache_num_pe; pe_index++)
+        for (way = 0; way < PGT_WALK_CACHE_WAYS; way++)
+            g_pgt_walk_cache[pe_index].way[way].valid = 0;
+}
+
+/**
+  @brief  Find the walk cache way of the current PE for a translation table, taking
+          the next way round robin if the table has none.
+
+  @param  root            Physical base of the root table
+  @param  ias             Input address size in bits
+  @param  page_size_log2  log2 of the translation granule
+
+  @return Walk cache way, NULL if there is no walk cache
+**/
+static pgt_walk_cache_t *pgt_walk_cache_lookup(uint64_t root, uint32_t ias,
+                                               uint32_t page_size_log2)
+{
+    pgt_walk_cache_set_t *set;
+    pgt_walk_cache_t *cache;
+    uint32_t pe_index, way;
+
+    if (g_pgt_walk_cache == NULL)
+        return NULL;
+
+    pe_index = val_pe_get_index_mpid(val_pe_get_mpid());
+    if (pe_index >= g_pgt_walk_cache_num_pe)
+        return NULL;
+
+    set = &g_pgt_walk_cache[pe_index];
+    for (way = 0; way < PGT_WALK_CACHE_WAYS; way++) {
+        cache = &set->way[way];
+        if ((cache->root == root) && (cache->ias == ias) &&
+            (cache->page_size_log2 == page_size_log2))
+            return cache;
+    }
+
+    cache = &set->way[set->victim];
+    set->victim = (set->victim + 1) % PGT_WALK_CACHE_WAYS;
+    cache->root = root;
+    cache->ias = ias;
+    cache->page_size_log2 = page_size_log2;
+    cache->valid = 0;
+    return cache;
+}
+
+/**
+  @brief Walk a translation table for a virtual address. The walk resumes from the
+         deepest table in the walk cache that translates the address, and records
+         the tables it reaches on the way down. Each PE caches the tables of the
+         last PGT_WALK_CACHE_WAYS translation tables it walked.
+  @param root - Physical base of the root translation table.
+  @param ias - Input address size in bits.
+  @param page_size_log2 - log2 of the translation granule.
+  @param virtual_address - virtual address to translate.
+  @param desc - output last descriptor read.
+  @param level - output lookup level of that descriptor.
+  @return 0 if the walk ends on a page or block descriptor, 1 otherwise
+**/
+uint32_t val_pgt_walk(uint64_t root, uint32_t ias, uint32_t page_size_log2,
+                      uint64_t virtual_address, uint64_t *desc, uint32_t *level)
+{
+    uint32_t index, num_pgt_levels, start_level, this_level;
+    uint32_t bits_at_this_level, bits_remaining, bits_per_level, cached_level;
+    uint64_t val64, tt_base_phys, *tt_base_virt, addr_mask;
+    pgt_walk_cache_t *cache = pgt_walk_cache_lookup(root, ias, page_size_log2);
 
     bits_per_level = page_size_log2 - 3;
     num_pgt_levels = (ias - page_size_log2 + bits_per_level - 1)/bits_per_level;
-    this_level = 4 - num_pgt_levels;
+    num_pgt_levels = (num_pgt_levels > 4)?4:num_pgt_levels;
+    start_level = 4 - num_pgt_levels;
+    addr_mask = ((0x1ull << (ias - page_size_log2)) - 1) << page_size_log2;
+
+    /* Start from the root table unless a deeper table translating the address is cached */
+    this_level = start_level;
+    tt_base_phys = root;
     bits_remaining = (num_pgt_levels - 1) * bits_per_level + page_size_log2;
     bits_at_this_level = ias - bits_remaining;
-    tt_base_phys = pgt_desc.pgt_base;
+
+    for (cached_level = PGT_LEVEL_3; (cache != NULL) && (cached_level > start_level);
+         cached_level--) {
+        bits_remaining = (PGT_LEVEL_3 - cached_level) * bits_per_level + page_size_log2;
+        if ((cache->valid & (0x1u << cached_level)) &&
+            (cache->tag[cached_level] == (virtual_address >> (bits_remaining + bits_per_level)))) {
+            this_level = cached_level;
+            tt_base_phys = cache->table[cached_level];
+            bits_at_this_level = bits_per_level;
+            break;
+        }
+    }
+    if (this_level == start_level)
+        bits_remaining = (num_pgt_levels - 1) * bits_per_level + page_size_log2;
 
     while (1) {
         index = (virtual_address >> bits_remaining) & ((0x1u << bits_at_this_level) - 1);
-        tt_base_virt = (uint64_t*)val_memory_phys_to_virt(tt_base_phys);
+        tt_base_virt = (uint64_t *)val_memory_phys_to_virt(tt_base_phys);
         val64 = tt_base_virt[index];
 
-        val_print(PGT_DEBUG_LEVEL,
-                  "\n       val_pgt_get_attributes: this_level = %d     ",
-                  this_level);
-        val_print(PGT_DEBUG_LEVEL,
-                  "\n       val_pgt_get_attributes: index = %d     ",
-                  index);
-        val_print(PGT_DEBUG_LEVEL,
-                  "\n       val_pgt_get_attributes: bits_remaining = %d     ",
-                  bits_remaining);
-        val_print(PGT_DEBUG_LEVEL,
-                  "\n       val_pgt_get_attributes: tt_base_virt = %x     ",
-                  (uint64_t)tt_base_virt);
-        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_get_attributes: val64 = %x     ", val64);
-        if (this_level == 3)
-        {
-            if (!IS_PGT_ENTRY_PAGE(val64))
-                return ACS_STATUS_ERR;
-            *attributes = PGT_DESC_ATTRIBUTES(val64);
-            return 0;
-        }
-        if (IS_PGT_ENTRY_BLOCK(val64)) {
-            *attributes = PGT_DESC_ATTRIBUTES(val64);
-            return 0;
-        }
-        tt_base_phys = val64 & (((0x1ull << (ias - page_size_log2)) - 1) << page_size_log2);
+        *desc = val64;
+        *level = this_level;
+
+        if (IS_PGT_ENTRY_INVALID(val64))
+            return 1;
+
+        /* Level 3 holds pages only, level 0 holds tables only */
+        if (this_level == PGT_LEVEL_3)
+            return !IS_PGT_ENTRY_PAGE(val64);
+
+        if (IS_PGT_ENTRY_BLOCK(val64))
+            return (this_level == PGT_LEVEL_0);
+
+        tt_base_phys = val64 & addr_mask;
         ++this_level;
-        bits_remaining -= bits_at_this_level;
+        bits_remaining -= bits_per_level;
         bits_at_this_level = bits_per_level;
+
+        if (cache == NULL)
+            continue;
+
+        cache->tag[this_level] = virtual_address >> (bits_remaining + bits_per_level);
+        cache->table[this_level] = tt_base_phys;
+        cache->valid |= (0x1u << this_level);
+    }
+}
+
+/**
+  @brief Get attributes of a page corresponding to a given virtual address.
+  @param pgt_desc - page table base and translation attributes.
+  @param virtual_address - virtual address of memory region base whose attribute is to be read.
+  @param attributes - output attributes
+  @return status
+**/
+uint64_t val_pgt_get_attributes(pgt_descriptor_t pgt_desc, uint64_t virtual_address,
+                                uint64_t *attributes)
+{
+    uint32_t level;
+    uint64_t val64;
+
+    if (attributes == NULL)
+        return ACS_STATUS_ERR;
+
+    if (!pgt_desc.pgt_base)
+        return ACS_STATUS_ERR;
+
+    if (val_pgt_walk(pgt_desc.pgt_base, (uint32_t)64 - pgt_desc.tcr.tsz,
+                     pgt_desc.tcr.tg_size_log2, virtual_address, &val64, &level))
+    {
+        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_get_attributes: no page or block, level = %d",
+                  level);
+        val_print(PGT_DEBUG_LEVEL, " val64 = %llx     ", val64);
+        return ACS_STATUS_ERR;
     }
+
+    *attributes = PGT_DESC_ATTRIBUTES(val64);
+    return 0;
 }
 
 /**
   @brief  This API free the translation table
 
+  @param  ctx       Page table context
   @param  tt_base   Translation Table Base
   @param  bits_at_this_level  number of bits
   @param  this_level  current translation level
 
   @return 0 if Success
 **/
-static void free_translation_table(uint64_t *tt_base, uint32_t bits_at_this_level,
-                                   uint32_t this_level)
+static void free_translation_table(pgt_ctx_t *ctx, uint64_t *tt_base,
+                                   uint32_t bits_at_this_level, uint32_t this_level)
 {
     uint32_t index;
     uint64_t *tt_base_next_virt;
@@ -477,10 +713,10 @@ static void free_translation_table(uint64_t *tt_base, uint32_t bits_at_this_leve
         {
             if (IS_PGT_ENTRY_BLOCK(tt_base[index]))
                 continue;
-            tt_base_next_virt = val_memory_phys_to_virt((tt_base[index] & pgt_addr_mask));
+            tt_base_next_virt = val_memory_phys_to_virt((tt_base[index] & ctx->addr_mask));
             if (tt_base_next_virt == NULL)
                 continue;
-            free_translation_table(tt_base_next_virt, bits_per_level, this_level+1);
+            free_translation_table(ctx, tt_base_next_virt, ctx->bits_per_level, this_level+1);
             val_print(PGT_DEBUG_LEVEL,
                       "\n       free_translation_table: tt_base_next_virt = %llx     ",
                       (uint64_t)tt_base_next_virt);
@@ -496,21 +732,22 @@ static void free_translation_table(uint64_t *tt_base, uint32_t bits_at_this_leve
 **/
 void val_pgt_destroy(pgt_descriptor_t pgt_desc)
 {
-    uint32_t page_size_log2, num_pgt_levels;
+    uint32_t num_pgt_levels;
+    pgt_ctx_t ctx;
     uint64_t *pgt_base_virt = val_memory_phys_to_virt(pgt_desc.pgt_base);
 
     if (!pgt_desc.pgt_base)
         return;
 
+    val_pgt_walk_cache_invalidate();
     val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_destroy: pgt_base = %llx     ", pgt_desc.pgt_base);
-    page_size = val_memory_page_size();
-    page_size_log2 = log2_page_size(page_size);
-    bits_per_level =  page_size_log2 - 3;
-    pgt_addr_mask = ((0x1ull << (pgt_desc.ias - page_size_log2)) - 1) << page_size_log2;
-    num_pgt_levels = (pgt_desc.ias - page_size_log2 + bits_per_level - 1)/bits_per_level;
-
-    free_translation_table(pgt_base_virt,
-                           pgt_desc.ias - ((num_pgt_levels - 1) * bits_per_level + page_size_log2),
+    pgt_ctx_setup(&ctx, pgt_desc.ias);
+    num_pgt_levels = (pgt_desc.ias - ctx.page_size_log2 + ctx.bits_per_level - 1) /
+                     ctx.bits_per_level;
+
+    free_translation_table(&ctx, pgt_base_virt,
+                           pgt_desc.ias - ((num_pgt_levels - 1) * ctx.bits_per_level +
+                                           ctx.page_size_log2),
                            4 - num_pgt_levels);
     val_memory_free_pages(pgt_base_virt, 1);
 }
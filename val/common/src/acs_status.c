@@ -17,6 +17,7 @@
 
 #include "common/include/acs_val.h"
 #include "common/include/acs_common.h"
+#include "common/include/acs_pe.h"
 
 extern uint32_t g_override_skip;
 
@@ -81,6 +82,7 @@ val_report_status(uint32_t index, uint32_t status, char8_t *ruleid)
           else
             val_print(ACS_PRINT_ERR, ": Result:  %8x\n", status);
 
+  val_print_flush();
 }
 
 /**
@@ -97,11 +99,18 @@ val_set_status(uint32_t index, uint32_t status)
 {
   volatile VAL_SHARED_MEM_t *mem;
 
-  mem = (VAL_SHARED_MEM_t *) pal_mem_get_shared_addr();
-  mem = mem + index;
+  mem = val_get_shared_mem_entry(index);
   mem->status = status;
 
   val_data_cache_ops_by_va((addr_t)&mem->status, CLEAN_AND_INVALIDATE);
+
+#ifndef TARGET_LINUX
+  /* A secondary PE leaving the pending state releases the primary PE, which may
+     be sleeping in val_wait_for_test_completion */
+  if (!IS_RESULT_PENDING(status) &&
+      (val_pe_get_index_mpid(val_pe_get_mpid()) != val_pe_get_primary_index()))
+      ArmCallSEV();
+#endif
 }
 
 /**
@@ -116,8 +125,7 @@ val_get_status(uint32_t index)
 {
   volatile VAL_SHARED_MEM_t *mem;
 
-  mem = (VAL_SHARED_MEM_t *) pal_mem_get_shared_addr();
-  mem = mem + index;
+  mem = val_get_shared_mem_entry(index);
 
   val_data_cache_ops_by_va((addr_t)&mem->status, INVALIDATE);
 
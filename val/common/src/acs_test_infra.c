@@ -18,15 +18,241 @@
 #include "common/include/acs_val.h"
 #include "common/include/acs_pe.h"
 #include "common/include/acs_common.h"
+#include "common/include/acs_memory.h"
+#include "common/include/acs_timer_support.h"
 #include "common/sys_arch_src/gic/acs_exception.h"
 #include "bsa/include/bsa_pal_interface.h"
 #include "common/include/val_interface.h"
 
 uint32_t g_override_skip;
 
+/* Per PE entries of the shared memory start at a cache writeback granule
+   aligned base and are padded to a multiple of the granule, so that no two
+   PEs share a line and each access needs a single line of maintenance */
+static addr_t   g_shared_mem_base;
+static uint32_t g_shared_mem_stride;
+
+/* Records of a deferred print, the string is formatted when the record is drained.
+   ticks orders the records of all rings when they are drained. */
+typedef struct {
+  char8_t   *string;
+  uint64_t   data;
+  uint64_t   ticks;
+  uint32_t   level;
+} VAL_PRINT_RECORD;
+
+/* Single producer (owning PE) single consumer (primary PE) ring of print records.
+   head is written by the owner and tail by the primary PE, each on a line of its
+   own so that neither side's cache maintenance writes back a stale copy of the
+   other's index. The ring size is a multiple of the line, see val_print_buffer_enable. */
+typedef struct {
+  uint32_t          head;
+  uint8_t           head_pad[VAL_PRINT_RING_LINE - sizeof(uint32_t)];
+  uint32_t          tail;
+  uint8_t           tail_pad[VAL_PRINT_RING_LINE - sizeof(uint32_t)];
+  VAL_PRINT_RECORD  rec[VAL_PRINT_RING_ENTRIES];
+} VAL_PRINT_RING;
+
+/* Per PE print rings, NULL when prints go synchronously to the console */
+static VAL_PRINT_RING *g_print_ring;
+
+static uint32_t val_shared_mem_get_granule(void);
+
+/* Structured result records, see val_result_stream_enable() */
+static uint32_t g_result_stream_enabled;
+static uint64_t g_test_start_ticks;
+
+#ifdef TARGET_BM_BOOT
+/* Heap arena of the running test, 0 if no test is running */
+static uint32_t g_test_mem_checkpoint;
+#endif
+
+/**
+  @brief  Send a formatted string to the PAL print layer right away.
+
+  @param level   the print verbosity (1 to 5)
+  @param string  formatted ASCII string
+  @param data    64-bit data. set to 0 if no data is to sent to console.
+
+  @return        None
+ **/
+static void
+val_print_direct(uint32_t level, char8_t *string, uint64_t data)
+{
+#ifndef TARGET_BM_BOOT
+  (void)level;
+  pal_print(string, data);
+#else
+  pal_uart_print(level, string, data);
+#endif
+}
+
+/**
+  @brief  Drain the print rings of all PEs to the PAL print layer, merging the
+          records of the rings in the order they were printed.
+          Only the primary PE drains the rings.
+
+  @param  None
+
+  @return None
+ **/
+static void
+val_print_drain_rings(void)
+{
+  VAL_PRINT_RING *ring;
+  VAL_PRINT_RECORD *rec, *oldest;
+  uint32_t i, next = 0;
+  uint32_t num_pe = val_pe_get_num();
+
+  /* Records enqueued after this point wait for the next drain */
+  for (i = 0; i < num_pe; i++)
+      val_data_cache_ops_by_va((addr_t)&g_print_ring[i].head, INVALIDATE);
+
+  while (1) {
+      oldest = NULL;
+      for (i = 0; i < num_pe; i++) {
+          ring = &g_print_ring[i];
+          if (ring->tail == ring->head)
+              continue;
+
+          rec = &ring->rec[ring->tail % VAL_PRINT_RING_ENTRIES];
+          val_data_cache_ops_by_va((addr_t)rec, INVALIDATE);
+          val_data_cache_ops_by_va((addr_t)rec + sizeof(VAL_PRINT_RECORD) - 1, INVALIDATE);
+          if ((oldest == NULL) || (rec->ticks < oldest->ticks)) {
+              oldest = rec;
+              next = i;
+          }
+      }
+
+      if (oldest == NULL)
+          break;
+
+      val_print_direct(oldest->level, oldest->string, oldest->data);
+      g_print_ring[next].tail++;
+  }
+
+  for (i = 0; i < num_pe; i++)
+      val_data_cache_ops_by_va((addr_t)&g_print_ring[i].tail, CLEAN_AND_INVALIDATE);
+}
+
+/**
+  @brief  Append a print to the ring of the calling PE. The rings are
+          drained once the ring of the primary PE reaches the high-water mark.
+
+  @param level   the print verbosity (1 to 5)
+  @param string  formatted ASCII string
+  @param data    64-bit data. set to 0 if no data is to sent to console.
+
+  @return        ACS_STATUS_PASS if buffered, ACS_STATUS_ERR if the ring of a
+                 secondary PE is full and the print has to go out directly.
+ **/
+static uint32_t
+val_print_enqueue(uint32_t level, char8_t *string, uint64_t data)
+{
+  uint32_t index = val_pe_get_index_mpid(val_pe_get_mpid());
+  uint32_t primary = (index == val_pe_get_primary_index());
+  VAL_PRINT_RING *ring = &g_print_ring[index];
+  VAL_PRINT_RECORD *rec;
+  uint32_t head = ring->head;
+
+  val_data_cache_ops_by_va((addr_t)&ring->tail, INVALIDATE);
+  if ((head - ring->tail) >= VAL_PRINT_RING_ENTRIES) {
+      if (!primary)
+          return ACS_STATUS_ERR;
+      val_print_drain_rings();
+  }
+
+  rec = &ring->rec[head % VAL_PRINT_RING_ENTRIES];
+  rec->string = string;
+  rec->data = data;
+  rec->ticks = val_get_counter();
+  rec->level = level;
+  val_data_cache_ops_by_va((addr_t)rec, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)rec + sizeof(VAL_PRINT_RECORD) - 1, CLEAN_AND_INVALIDATE);
+
+  ring->head = ++head;
+  val_data_cache_ops_by_va((addr_t)&ring->head, CLEAN_AND_INVALIDATE);
+
+  if (primary && ((head - ring->tail) >= VAL_PRINT_RING_HIGH_WATER))
+      val_print_drain_rings();
+
+  return ACS_STATUS_PASS;
+}
+
+/**
+  @brief  This API drains the print rings of all PEs to the output console.
+          Prints are drained at test boundaries, and this API is the escape
+          hatch for paths which must get the log out immediately.
+          It has no effect when called on a secondary PE.
+          1. Caller       - VAL, Application layer
+          2. Prerequisite - None.
+
+  @param  None
+
+  @return None
+ **/
+void
+val_print_flush(void)
+{
+  if (g_print_ring == NULL)
+      return;
+
+  if (val_pe_get_index_mpid(val_pe_get_mpid()) != val_pe_get_primary_index())
+      return;
+
+  val_print_drain_rings();
+}
+
+/**
+  @brief  This API enables or disables buffered printing. With buffering
+          enabled, val_print appends to a per PE ring instead of calling the
+          PAL print layer, and the rings are drained by the primary PE at
+          test boundaries or when its ring reaches the high-water mark.
+          1. Caller       - Application layer
+          2. Prerequisite - val_pe_create_info_table
+
+  @param enable  1 to buffer prints, 0 to flush and print synchronously
+
+  @return        ACS_STATUS_PASS, or ACS_STATUS_ERR if the rings could not be allocated
+                 or the cache writeback granule exceeds VAL_PRINT_RING_LINE
+ **/
+uint32_t
+val_print_buffer_enable(uint32_t enable)
+{
+  VAL_PRINT_RING *ring = g_print_ring;
+
+  if (!enable) {
+      val_print_flush();
+      g_print_ring = NULL;
+      val_data_cache_ops_by_va((addr_t)&g_print_ring, CLEAN_AND_INVALIDATE);
+      if (ring != NULL)
+          val_memory_free_aligned(ring);
+      return ACS_STATUS_PASS;
+  }
+
+  if (ring != NULL)
+      return ACS_STATUS_PASS;
+
+  /* The padding of the rings only keeps head and tail apart up to this granule */
+  if (val_shared_mem_get_granule() > VAL_PRINT_RING_LINE)
+      return ACS_STATUS_ERR;
+
+  ring = val_aligned_alloc(VAL_PRINT_RING_LINE, val_pe_get_num() * sizeof(VAL_PRINT_RING));
+  if (ring == NULL)
+      return ACS_STATUS_ERR;
+
+  val_memory_set(ring, val_pe_get_num() * sizeof(VAL_PRINT_RING), 0);
+  val_pe_cache_clean_range((uint64_t)ring, (uint64_t)val_pe_get_num() * sizeof(VAL_PRINT_RING));
+  g_print_ring = ring;
+  val_data_cache_ops_by_va((addr_t)&g_print_ring, CLEAN_AND_INVALIDATE);
+
+  return ACS_STATUS_PASS;
+}
+
 /**
   @brief  This API calls PAL layer to print a formatted string
-          to the output console.
+          to the output console. With buffered printing enabled the
+          string is queued and printed when the print rings are drained.
           1. Caller       - Application layer
           2. Prerequisite - None.
 
@@ -39,15 +265,13 @@ uint32_t g_override_skip;
 void
 val_print(uint32_t level, char8_t *string, uint64_t data)
 {
-#ifndef TARGET_BM_BOOT
-  if (level >= g_print_level)
-      pal_print(string, data);
-#else
-  if (level >= g_print_level) {
-      pal_uart_print(level, string, data);
-  }
-#endif
+  if (level < g_print_level)
+      return;
 
+  if ((g_print_ring != NULL) && (val_print_enqueue(level, string, data) == ACS_STATUS_PASS))
+      return;
+
+  val_print_direct(level, string, data);
 }
 
 /**
@@ -115,6 +339,7 @@ val_print_test_end(uint32_t status, char8_t *string)
   }
 
   val_print(ACS_PRINT_TEST, "\n", 0);
+  val_print_flush();
 
 }
 
@@ -318,6 +543,235 @@ val_check_skip_module(uint32_t module_base)
   return ACS_STATUS_PASS;
 }
 
+#ifdef ACS_PROFILE
+#define VAL_PROFILE_MAX_TESTS    512
+#define VAL_PROFILE_TOP_TESTS    20
+#define VAL_PROFILE_MAX_MODULES  16
+
+/* Timing of one test, in generic counter ticks */
+typedef struct {
+  uint32_t  test_num;
+  uint64_t  total;
+  uint64_t  pe_max;                        /* slowest payload run by a secondary PE */
+  uint64_t  phase[VAL_PROFILE_PHASE_MAX];
+} VAL_PROFILE_RECORD;
+
+static VAL_PROFILE_RECORD  g_profile[VAL_PROFILE_MAX_TESTS];
+static VAL_PROFILE_RECORD *g_profile_cur;
+static uint32_t            g_profile_count;
+static uint64_t            g_profile_phase_start[VAL_PROFILE_PHASE_MAX];
+
+static char8_t *g_profile_phase_name[VAL_PROFILE_PHASE_MAX] = {
+  "Init", "Dispatch", "Payload", "Wait", "Report"
+};
+
+/**
+  @brief  Open the profile record of a test which is not skipped. The init
+          phase is accounted from the entry of val_initialize_test.
+
+  @param test_num  unique number identifying this test
+  @param num_pe    the number of PE to execute this test on
+
+  @return        None
+ **/
+static void
+val_profile_test_start(uint32_t test_num, uint32_t num_pe)
+{
+  uint32_t i;
+  volatile VAL_SHARED_MEM_t *entry;
+
+  if (g_profile_count >= VAL_PROFILE_MAX_TESTS) {
+      g_profile_cur = NULL;
+      return;
+  }
+
+  for (i = 0; i < num_pe; i++) {
+      entry = val_get_shared_mem_entry(i);
+      entry->payload_ticks = 0;
+      val_data_cache_ops_by_va((addr_t)&entry->payload_ticks, CLEAN_AND_INVALIDATE);
+  }
+
+  g_profile_cur = &g_profile[g_profile_count++];
+  g_profile_cur->test_num = test_num;
+  g_profile_cur->phase[VAL_PROFILE_INIT] = val_get_counter() - g_test_start_ticks;
+}
+
+/**
+  @brief  Close the profile record of the current test and collect the
+          payload time reported by the secondary PEs.
+
+  @param num_pe    the number of PE which executed this test
+
+  @return        None
+ **/
+static void
+val_profile_test_end(uint32_t num_pe)
+{
+  uint32_t i;
+  volatile VAL_SHARED_MEM_t *entry;
+
+  if (g_profile_cur == NULL)
+      return;
+
+  g_profile_cur->total = val_get_counter() - g_test_start_ticks;
+
+  for (i = 0; i < num_pe; i++) {
+      entry = val_get_shared_mem_entry(i);
+      val_data_cache_ops_by_va((addr_t)&entry->payload_ticks, INVALIDATE);
+      if (entry->payload_ticks > g_profile_cur->pe_max)
+          g_profile_cur->pe_max = entry->payload_ticks;
+  }
+
+  g_profile_cur = NULL;
+}
+
+/**
+  @brief  Convert generic counter ticks to milliseconds without overflowing.
+
+  @param ticks  counter ticks
+  @param freq   counter frequency in Hz
+
+  @return       time in milliseconds, 0 if the frequency is not known
+ **/
+static uint64_t
+val_profile_ticks_to_ms(uint64_t ticks, uint64_t freq)
+{
+  if (!freq)
+      return 0;
+
+  return ((ticks / freq) * ONE_MILLISECOND) + (((ticks % freq) * ONE_MILLISECOND) / freq);
+}
+
+/**
+  @brief  This API marks the start of a phase of the current test.
+          1. Caller       - VAL
+          2. Prerequisite - None.
+
+  @param phase  phase from VAL_PROFILE_PHASE_e
+
+  @return        None
+ **/
+void
+val_profile_phase_begin(uint32_t phase)
+{
+  if (phase < VAL_PROFILE_PHASE_MAX)
+      g_profile_phase_start[phase] = val_get_counter();
+}
+
+/**
+  @brief  This API accounts the time since val_profile_phase_begin to the
+          phase of the current test. A phase may be entered more than once.
+          1. Caller       - VAL
+          2. Prerequisite - val_profile_phase_begin
+
+  @param phase  phase from VAL_PROFILE_PHASE_e
+
+  @return        None
+ **/
+void
+val_profile_phase_end(uint32_t phase)
+{
+  if ((g_profile_cur == NULL) || (phase >= VAL_PROFILE_PHASE_MAX))
+      return;
+
+  g_profile_cur->phase[phase] += val_get_counter() - g_profile_phase_start[phase];
+}
+
+/**
+  @brief  This API records the payload time of a secondary PE in its shared
+          memory entry, it is collected by the primary PE at the end of the test.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param index        index of the PE which ran the payload
+  @param start_ticks  counter value read before the payload was called
+
+  @return        None
+ **/
+void
+val_profile_pe_payload(uint32_t index, uint64_t start_ticks)
+{
+  volatile VAL_SHARED_MEM_t *entry = val_get_shared_mem_entry(index);
+
+  entry->payload_ticks = val_get_counter() - start_ticks;
+  val_data_cache_ops_by_va((addr_t)&entry->payload_ticks, CLEAN_AND_INVALIDATE);
+}
+
+/**
+  @brief  This API prints the slowest tests with their phase breakdown and
+          the time spent in every module, both sorted slowest first.
+          1. Caller       - Application layer
+          2. Prerequisite - None.
+
+  @param  None
+
+  @return None
+ **/
+void
+val_profile_report(void)
+{
+  uint32_t i, j, num_top = 0, slowest;
+  uint32_t top[VAL_PROFILE_TOP_TESTS];
+  uint64_t module_ticks[VAL_PROFILE_MAX_MODULES] = {0};
+  uint64_t freq = val_time_us_to_ticks(ONE_MILLISECOND * ONE_MILLISECOND);
+  VAL_PROFILE_RECORD *rec;
+
+  /* Keep the slowest tests in top[], ordered slowest first */
+  for (i = 0; i < g_profile_count; i++) {
+      rec = &g_profile[i];
+      if (rec->test_num / 100 < VAL_PROFILE_MAX_MODULES)
+          module_ticks[rec->test_num / 100] += rec->total;
+
+      if ((num_top == VAL_PROFILE_TOP_TESTS) && (rec->total <= g_profile[top[num_top - 1]].total))
+          continue;
+
+      if (num_top < VAL_PROFILE_TOP_TESTS)
+          num_top++;
+
+      for (j = num_top - 1; (j > 0) && (g_profile[top[j - 1]].total < rec->total); j--)
+          top[j] = top[j - 1];
+      top[j] = i;
+  }
+
+  val_print(ACS_PRINT_ERR, "\n     Profile : slowest tests (ms), %d tests timed\n", g_profile_count);
+  val_print(ACS_PRINT_ERR, "      Test     Total", 0);
+  for (j = 0; j < VAL_PROFILE_PHASE_MAX; j++) {
+      val_print(ACS_PRINT_ERR, "  ", 0);
+      val_print(ACS_PRINT_ERR, g_profile_phase_name[j], 0);
+  }
+  val_print(ACS_PRINT_ERR, "  PE max\n", 0);
+
+  for (i = 0; i < num_top; i++) {
+      rec = &g_profile[top[i]];
+      val_print(ACS_PRINT_ERR, "      %4d", rec->test_num);
+      val_print(ACS_PRINT_ERR, " %9ld", val_profile_ticks_to_ms(rec->total, freq));
+      for (j = 0; j < VAL_PROFILE_PHASE_MAX; j++)
+          val_print(ACS_PRINT_ERR, " %7ld", val_profile_ticks_to_ms(rec->phase[j], freq));
+      val_print(ACS_PRINT_ERR, " %7ld\n", val_profile_ticks_to_ms(rec->pe_max, freq));
+  }
+
+  val_print(ACS_PRINT_ERR, "\n     Profile : modules (ms)\n", 0);
+  while (1) {
+      slowest = VAL_PROFILE_MAX_MODULES;
+      for (i = 0; i < VAL_PROFILE_MAX_MODULES; i++) {
+          if (module_ticks[i] && ((slowest == VAL_PROFILE_MAX_MODULES) ||
+                                  (module_ticks[i] > module_ticks[slowest])))
+              slowest = i;
+      }
+      if (slowest == VAL_PROFILE_MAX_MODULES)
+          break;
+
+      val_print(ACS_PRINT_ERR, "      Tests %4d", slowest * 100);
+      val_print(ACS_PRINT_ERR, " - %4d", (slowest * 100) + 99);
+      val_print(ACS_PRINT_ERR, " %9ld\n", val_profile_ticks_to_ms(module_ticks[slowest], freq));
+      module_ticks[slowest] = 0;
+  }
+}
+#else
+#define val_profile_test_start(test_num, num_pe)  ((void)0)
+#define val_profile_test_end(num_pe)              ((void)0)
+#endif
+
 /**
   @brief  This API prints the test number, description and
           sets the test status to pending for the input number of PEs.
@@ -338,6 +792,7 @@ val_initialize_test(uint32_t test_num, char8_t *desc, uint32_t num_pe)
   uint32_t index = val_pe_get_index_mpid(val_pe_get_mpid());
 
   g_override_skip = 0;
+  g_test_start_ticks = val_get_counter();
 
   for (i = 0; i < num_pe; i++)
       val_set_status(i, RESULT_PENDING(test_num));
@@ -379,10 +834,40 @@ val_initialize_test(uint32_t test_num, char8_t *desc, uint32_t num_pe)
   val_pe_initialize_default_exception_handler(val_pe_default_esr);
 
   g_acs_tests_total++;
+  val_profile_test_start(test_num, num_pe);
+#ifdef TARGET_BM_BOOT
+  g_test_mem_checkpoint = val_memory_arena_checkpoint();
+#endif
 
   return ACS_STATUS_PASS;
 }
 
+/**
+  @brief  Return the cache writeback granule in bytes as reported by
+          CTR_EL0.CWG, or the smallest data cache line if CWG is not
+          reported.
+
+  @param  None
+
+  @return Granule size in bytes
+**/
+static uint32_t
+val_shared_mem_get_granule(void)
+{
+#ifndef TARGET_LINUX
+  uint64_t ctr = val_pe_reg_read(CTR_EL0);
+  uint32_t cwg = (ctr >> 24) & 0xF;
+  uint32_t dminline = (ctr >> 16) & 0xF;
+
+  if (cwg < dminline)
+      cwg = dminline;
+
+  return 4 << cwg;
+#else
+  return 64;
+#endif
+}
+
 /**
   @brief  Allocate memory which is to be shared across PEs
 
@@ -393,9 +878,48 @@ val_initialize_test(uint32_t test_num, char8_t *desc, uint32_t num_pe)
 void
 val_allocate_shared_mem()
 {
+  uint32_t i, granule;
+  addr_t base;
+
+  granule = val_shared_mem_get_granule();
+  g_shared_mem_stride = granule;
+  while (g_shared_mem_stride < sizeof(VAL_SHARED_MEM_t))
+      g_shared_mem_stride += granule;
+
+  /* One spare entry leaves room to align the base to the granule */
+  pal_mem_allocate_shared(val_pe_get_num() + 1, g_shared_mem_stride);
+
+  base = (addr_t)pal_mem_get_shared_addr();
+  g_shared_mem_base = (base + granule - 1) & ~((addr_t)granule - 1);
+  val_data_cache_ops_by_va((addr_t)&g_shared_mem_base, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_shared_mem_stride, CLEAN_AND_INVALIDATE);
+
+  if (base == 0)
+      return;
+
+  val_print(ACS_PRINT_DEBUG, " Shared memory entry size per PE   : %d\n", g_shared_mem_stride);
 
-  pal_mem_allocate_shared(val_pe_get_num(), sizeof(VAL_SHARED_MEM_t));
+  /* No PE is resident in the worker pool to begin with */
+  for (i = 0; i < val_pe_get_num(); i++)
+      val_set_pool_state(i, VAL_PE_POOL_OFF);
+}
+
+/**
+  @brief  Return the shared memory entry of the PE identified by index.
+          The entry is aligned to the cache writeback granule and lies
+          within a single line.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param  index  the PE Index
 
+  @return Pointer to the shared memory entry of the PE
+**/
+volatile VAL_SHARED_MEM_t *
+val_get_shared_mem_entry(uint32_t index)
+{
+  return (volatile VAL_SHARED_MEM_t *)(g_shared_mem_base +
+                                       (addr_t)index * g_shared_mem_stride);
 }
 
 /**
@@ -411,6 +935,9 @@ void
 val_free_shared_mem()
 {
 
+  /* Parked PEs poll the shared memory, power them off before freeing it */
+  val_pe_pool_enable(0);
+  val_print_buffer_enable(0);
   pal_mem_free_shared();
 }
 
@@ -438,14 +965,12 @@ val_set_test_data(uint32_t index, uint64_t addr, uint64_t test_data)
       return;
   }
 
-  mem = (VAL_SHARED_MEM_t *)pal_mem_get_shared_addr();
-  mem = mem + index;
+  mem = val_get_shared_mem_entry(index);
 
   mem->data0 = addr;
   mem->data1 = test_data;
 
-  val_data_cache_ops_by_va((addr_t)&mem->data0, CLEAN_AND_INVALIDATE);
-  val_data_cache_ops_by_va((addr_t)&mem->data1, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)mem, CLEAN_AND_INVALIDATE);
 }
 
 /**
@@ -473,55 +998,167 @@ val_get_test_data(uint32_t index, uint64_t *data0, uint64_t *data1)
       return;
   }
 
-  mem = (VAL_SHARED_MEM_t *) pal_mem_get_shared_addr();
-  mem = mem + index;
+  mem = val_get_shared_mem_entry(index);
 
-  val_data_cache_ops_by_va((addr_t)&mem->data0, INVALIDATE);
-  val_data_cache_ops_by_va((addr_t)&mem->data1, INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)mem, INVALIDATE);
 
   *data0 = mem->data0;
   *data1 = mem->data1;
 
 }
 
+/**
+  @brief  This function records the worker pool state of the PE identified
+          by index in its shared mailbox.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param index   the PE Index
+  @param state   one of the VAL_PE_POOL_* states
+
+  @return        None
+ **/
+void
+val_set_pool_state(uint32_t index, uint32_t state)
+{
+  volatile VAL_SHARED_MEM_t *mem;
+
+  mem = val_get_shared_mem_entry(index);
+  mem->pool_state = state;
+
+  val_data_cache_ops_by_va((addr_t)&mem->pool_state, CLEAN_AND_INVALIDATE);
+}
+
+/**
+  @brief  This function returns the worker pool state of the PE identified
+          by index from its shared mailbox.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param index   the PE Index
+
+  @return        one of the VAL_PE_POOL_* states
+ **/
+uint32_t
+val_get_pool_state(uint32_t index)
+{
+  volatile VAL_SHARED_MEM_t *mem;
+
+  mem = val_get_shared_mem_entry(index);
+
+  val_data_cache_ops_by_va((addr_t)&mem->pool_state, INVALIDATE);
+
+  return mem->pool_state;
+}
+
+/**
+  @brief  This API returns the current value of the generic physical counter.
+          1. Caller       - VAL, Test Suite
+          2. Prerequisite - None.
+
+  @param  None
+
+  @return Counter value, 0 if the counter is not accessible
+ **/
+uint64_t
+val_get_counter(void)
+{
+#ifndef TARGET_LINUX
+  return ArmReadCntPct();
+#else
+  return 0;
+#endif
+}
+
+/**
+  @brief  This API converts a time in microseconds to generic counter ticks.
+          1. Caller       - VAL, Test Suite
+          2. Prerequisite - None.
+
+  @param  time_us  time in microseconds
+
+  @return Number of counter ticks, 0 if the counter is not accessible
+ **/
+uint64_t
+val_time_us_to_ticks(uint64_t time_us)
+{
+#ifndef TARGET_LINUX
+  return (time_us * ArmReadCntFrq()) / ONE_MILLISECOND / ONE_MILLISECOND;
+#else
+  (void)time_us;
+  return 0;
+#endif
+}
+
 /**
   @brief  This function will wait for all PEs to report their status
-          or we timeout and set a failure for the PE which timed-out
+          or we timeout and set a failure for the PE which timed-out.
+          The wait is bounded by the generic counter. PEs which have
+          reported are not polled again, and if FEAT_WFxT is present the
+          PE sleeps in WFET between polls, woken by val_set_status.
           1. Caller       - Application layer
           2. Prerequisite - val_set_status
 
-  @param test_num  Unique test number
-  @param num_pe    Number of PE who are executing this test
-  @param timeout   integer value ob expiry the API will timeout and return
+  @param test_num    Unique test number
+  @param num_pe      Number of PE who are executing this test
+  @param timeout_us  time in microseconds after which the API will timeout and return
 
   @return        None
  **/
 
 static void
-val_wait_for_test_completion(uint32_t test_num, uint32_t num_pe, uint32_t timeout)
+val_wait_for_test_completion(uint32_t test_num, uint32_t num_pe, uint64_t timeout_us)
 {
 
-  uint32_t i = 0, j = 0;
+  uint32_t i, first = 0, last = 0, pending;
+  uint32_t timeout = TIMEOUT_LARGE;
+  uint64_t start, ticks, elapsed;
+#ifndef TARGET_LINUX
+  uint32_t wfet;
+#endif
 
   //For single PE tests, there is no need to wait for the results
   if (num_pe == 1)
       return;
 
-  while(--timeout)
+  /* Fall back to the TIMEOUT_LARGE loop count where the counter is not accessible */
+  ticks = val_time_us_to_ticks(timeout_us);
+  start = val_get_counter();
+#ifndef TARGET_LINUX
+  wfet = (VAL_EXTRACT_BITS(val_pe_reg_read(ID_AA64ISAR2_EL1), 0, 3) >= 2);
+#endif
+
+  while (1)
   {
-      j = 0;
-      for (i = 0; i < num_pe; i++)
+      pending = 0;
+      //PEs below first have already reported their status
+      for (i = first; i < num_pe; i++)
       {
           if (IS_RESULT_PENDING(val_get_status(i))) {
-              j = i+1;
+              if (!pending)
+                  first = i;
+              pending = 1;
+              last = i;
           }
       }
       //If None of the PE have the status as Pending, return
-      if (!j)
+      if (!pending)
           return;
+
+      if (ticks) {
+          elapsed = val_get_counter() - start;
+          if (elapsed >= ticks)
+              break;
+#ifndef TARGET_LINUX
+          if (wfet)
+              ArmCallWFET(ticks - elapsed);
+#endif
+      } else if (!--timeout)
+          break;
   }
+
   //We are here if we timed-out, set the last index PE as failed
-  val_set_status(j-1, RESULT_FAIL(test_num, 0xF));
+  val_set_status(last, RESULT_FAIL(test_num, 0xF));
 }
 
 /**
@@ -540,26 +1177,81 @@ void
 val_run_test_payload(uint32_t test_num, uint32_t num_pe, void (*payload)(void), uint64_t test_input)
 {
 
-  uint32_t my_index = val_pe_get_index_mpid(val_pe_get_mpid());
-  uint32_t i;
-
+  val_profile_phase_begin(VAL_PROFILE_PAYLOAD);
   payload();  //this is test run separately on present PE
+  val_profile_phase_end(VAL_PROFILE_PAYLOAD);
   if (num_pe == 1)
       return;
 
   //Now run the test on all other PE
-  for (i = 0; i < num_pe; i++) {
-      if (i != my_index)
-          val_execute_on_pe(i, payload, test_input);
-  }
+  val_profile_phase_begin(VAL_PROFILE_DISPATCH);
+  val_execute_on_all_pe(num_pe, payload, test_input);
+  val_profile_phase_end(VAL_PROFILE_DISPATCH);
 
-  val_wait_for_test_completion(test_num, num_pe, TIMEOUT_LARGE);
+  val_profile_phase_begin(VAL_PROFILE_WAIT);
+  val_wait_for_test_completion(test_num, num_pe, TIMEOUT_US_LARGE);
+  val_profile_phase_end(VAL_PROFILE_WAIT);
 }
 
 /**
-  @brief  Prints the status of the completed test
-          1. Caller       - Test Suite
-          2. Prerequisite - val_set_status
+  @brief  This API enables or disables the structured result stream. With the
+          stream enabled, every test verdict is followed by one ACSR record
+          line which tools/scripts/acs_results_junit.py converts to JUnit XML.
+          An ACSH header line carrying the counter frequency is emitted when
+          the stream is enabled.
+          1. Caller       - Application layer
+          2. Prerequisite - None.
+
+  @param enable  1 to emit result records, 0 to stop
+
+  @return        None
+ **/
+void
+val_result_stream_enable(uint32_t enable)
+{
+  g_result_stream_enabled = enable;
+
+  if (enable)
+      val_print(ACS_PRINT_ERR, "\nACSH %llx\n",
+                val_time_us_to_ticks(ONE_MILLISECOND * ONE_MILLISECOND));
+}
+
+/**
+  @brief  Emit the structured record of a test verdict.
+          The record is "ACSR <word> <ticks> <ruleid>" where word packs the
+          test number [63:48], the reporting PE index [47:32] and its status
+          word [31:0], and ticks is the generic counter time since
+          val_initialize_test. The status fields are not decoded on target,
+          so a record costs fewer PAL print calls than the text report.
+          1. Caller       - VAL
+          2. Prerequisite - val_initialize_test
+
+  @param test_num  Unique test number
+  @param index     index of the PE whose status is reported
+  @param status    32-bit status word reported by the PE
+  @param ruleid    Rule ID of the test, may be NULL
+
+  @return        None
+ **/
+void
+val_report_result_record(uint32_t test_num, uint32_t index, uint32_t status, char8_t *ruleid)
+{
+  uint64_t word;
+
+  /* Same rule as the text report, tests filtered out by -t/-m/-skip stay quiet */
+  if (!g_result_stream_enabled || !g_override_skip)
+      return;
+
+  word = ((uint64_t)(test_num & 0xFFFF) << 48) | ((uint64_t)(index & 0xFFFF) << 32) | status;
+
+  val_print(ACS_PRINT_ERR, "\nACSR %llx", word);
+  val_print(ACS_PRINT_ERR, " %llx ", val_get_counter() - g_test_start_ticks);
+  val_print(ACS_PRINT_ERR, ruleid ? ruleid : "-", 0);
+  val_print(ACS_PRINT_ERR, "\n", 0);
+}
+
+/**
+  @brief  Collect and report the status of the PEs which ran the test
 
   @param test_num   unique test number
   @param num_pe     The number of PEs to query for status
@@ -567,20 +1259,20 @@ val_run_test_payload(uint32_t test_num, uint32_t num_pe, void (*payload)(void),
 
   @return     Success or on failure - status of the last failed PE
  **/
-uint32_t
-val_check_for_error(uint32_t test_num, uint32_t num_pe, char8_t *ruleid)
+static uint32_t
+val_collect_test_status(uint32_t test_num, uint32_t num_pe, char8_t *ruleid)
 {
   uint32_t i;
   uint32_t status = 0;
   uint32_t error_flag = 0;
   uint32_t my_index = val_pe_get_index_mpid(val_pe_get_mpid());
-  (void) test_num;
 
   /* this special case is needed when the Main PE is not the first entry
      of pe_info_table but num_pe is 1 for SOC tests */
   if (num_pe == 1) {
       status = val_get_status(my_index);
       val_report_status(my_index, status, ruleid);
+      val_report_result_record(test_num, my_index, status, ruleid);
       if (IS_TEST_PASS(status)) {
           g_acs_tests_pass++;
           return ACS_STATUS_PASS;
@@ -606,6 +1298,8 @@ val_check_for_error(uint32_t test_num, uint32_t num_pe, char8_t *ruleid)
   if (!error_flag)
       val_report_status(my_index, status, ruleid);
 
+  val_report_result_record(test_num, error_flag ? i : my_index, status, ruleid);
+
   if (IS_TEST_PASS(status)) {
       g_acs_tests_pass++;
       return ACS_STATUS_PASS;
@@ -618,6 +1312,42 @@ val_check_for_error(uint32_t test_num, uint32_t num_pe, char8_t *ruleid)
   return ACS_STATUS_FAIL;
 }
 
+/**
+  @brief  Prints the status of the completed test
+          1. Caller       - Test Suite
+          2. Prerequisite - val_set_status
+
+  @param test_num   unique test number
+  @param num_pe     The number of PEs to query for status
+  @param *ruleid    RuleID of the test
+
+  @return     Success or on failure - status of the last failed PE
+ **/
+uint32_t
+val_check_for_error(uint32_t test_num, uint32_t num_pe, char8_t *ruleid)
+{
+  uint32_t status;
+#ifdef TARGET_BM_BOOT
+  uint64_t leaked;
+#endif
+
+  val_profile_phase_begin(VAL_PROFILE_REPORT);
+  status = val_collect_test_status(test_num, num_pe, ruleid);
+  val_profile_phase_end(VAL_PROFILE_REPORT);
+  val_profile_test_end(num_pe);
+
+#ifdef TARGET_BM_BOOT
+  if (g_test_mem_checkpoint) {
+      leaked = val_memory_arena_release(g_test_mem_checkpoint);
+      if (leaked)
+          val_print(ACS_PRINT_DEBUG, "\n       Test left %ld bytes of heap allocated", leaked);
+      g_test_mem_checkpoint = 0;
+  }
+#endif
+
+  return status;
+}
+
 /**
   @brief  Clean and Invalidate the Data cache line containing
           the input address tag
@@ -1,5 +1,5 @@
 /** @file
- * Copyright (c) 2021, 2023-2024, Arm Limited or its affiliates. All rights reserved.
+ * Copyright (c) 2021, 2023-2025, Arm Limited or its affiliates. All rights reserved.
  * SPDX-License-Identifier : Apache-2.0
 
  * Licensed under the Apache License, Version 2.0 (the "License");
@@ -322,7 +322,7 @@ WriteCmdQMAPD(
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2),
                      (uint64_t)((Valid << ITS_CMD_SHIFT_VALID) | (ITT_BASE & ITT_PAR_MASK)));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0x0));
-    g_cwriter_ptr[its_index] = g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR;
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
 }
 
 static void
@@ -340,7 +340,7 @@ WriteCmdQMAPC(
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2),
                      (uint64_t)((Valid << ITS_CMD_SHIFT_VALID) | RDBase | Clctn_ID));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0x0));
-    g_cwriter_ptr[its_index] = g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR;
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
 }
 
 static void
@@ -358,7 +358,7 @@ WriteCmdQMAPTI(
                      ((uint64_t)(int_id-ARM_LPI_MINID) | ((uint64_t)int_id << 32)));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2), (uint64_t)(Clctn_ID));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0));
-    g_cwriter_ptr[its_index] = g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR;
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
 }
 
 static void
@@ -375,7 +375,22 @@ WriteCmdQINV(
                      (uint64_t)(int_id-ARM_LPI_MINID));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2), (uint64_t)(0x0));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0x0));
-    g_cwriter_ptr[its_index] = g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR;
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
+}
+
+static void
+WriteCmdQINVALL(
+   uint32_t     its_index,
+   uint64_t     *CMDQ_BASE,
+   uint32_t     Clctn_ID
+  )
+{
+    val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index]),
+                     (uint64_t)(ARM_ITS_CMD_INVALL));
+    val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 1), (uint64_t)(0x0));
+    val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2), (uint64_t)(Clctn_ID));
+    val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0x0));
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
 }
 
 static void
@@ -392,7 +407,7 @@ WriteCmdQDISCARD(
                      (uint64_t)(int_id-ARM_LPI_MINID));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2), (uint64_t)(0x0));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0x0));
-    g_cwriter_ptr[its_index] = g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR;
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
 }
 
 
@@ -408,7 +423,7 @@ WriteCmdQSYNC(
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 1), (uint64_t)(0x0));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 2), (uint64_t)(RDBase));
     val_mmio_write64((uint64_t)(CMDQ_BASE + g_cwriter_ptr[its_index] + 3), (uint64_t)(0x0));
-    g_cwriter_ptr[its_index] = g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR;
+    g_cwriter_ptr[its_index] = (g_cwriter_ptr[its_index] + ITS_NEXT_CMD_PTR) % ITS_CMDQ_NUM_DW;
 }
 
 static void PollTillCommandQueueDone(uint32_t its_index)
@@ -472,27 +487,58 @@ static uint64_t GetRDBaseFormat(uint32_t its_index)
 }
 
 
-void val_its_clear_lpi_map(uint32_t its_index, uint32_t device_id, uint32_t int_id)
+static void PublishCommands(uint32_t its_index)
 {
   uint64_t    value;
-  uint64_t    RDBase;
   uint64_t    ItsBase;
+
+  ItsBase = g_gic_its_info->GicIts[its_index].Base;
+
+  TestExecuteBarrier();
+
+  /* Update the CWRITER Register so that all the commands from Command queue gets executed.*/
+  value = ((g_cwriter_ptr[its_index] * NUM_BYTES_IN_DW));
+  val_mmio_write64((ItsBase + ARM_GITS_CWRITER), value);
+
+  /* Check CREADR value which ensures Command Queue is processed */
+  PollTillCommandQueueDone(its_index);
+  TestExecuteBarrier();
+}
+
+/**
+  @brief   Unmap the LPIs int_id to int_id + num_ids - 1 of a device. The DISCARD
+           commands of the whole range are published with one MAPD and one SYNC.
+  @param   its_index  ITS index
+  @param   device_id  Device ID
+  @param   int_id     First LPI, the EventID is int_id - ARM_LPI_MINID
+  @param   num_ids    Number of LPIs
+  @return  None
+**/
+void val_its_clear_lpi_map_range(uint32_t its_index, uint32_t device_id,
+                                 uint32_t int_id, uint32_t num_ids)
+{
+  uint32_t    index;
+  uint64_t    RDBase;
   uint64_t    ItsCommandBase;
 
   if (!g_its_setup_done)
     return;
 
-  ItsBase        = g_gic_its_info->GicIts[its_index].Base;
   ItsCommandBase = g_gic_its_info->GicIts[its_index].CommandQBase;
 
-  /* Clear Config table for LPI=int_id */
-  ClearConfigTable(int_id);
-
   /* Get RDBase Depending on GITS_TYPER.PTA */
   RDBase = GetRDBaseFormat(its_index);
 
-  /* Discard Mappings */
-  WriteCmdQDISCARD(its_index, (uint64_t *)(ItsCommandBase), device_id, int_id);
+  for (index = 0; index < num_ids; index++) {
+    /* Clear Config table for LPI=int_id */
+    ClearConfigTable(int_id + index);
+
+    /* Discard Mappings, publishing before the queue can fill up */
+    WriteCmdQDISCARD(its_index, (uint64_t *)(ItsCommandBase), device_id, int_id + index);
+    if ((index + 1) % ITS_CMDQ_BATCH_MAX == 0)
+      PublishCommands(its_index);
+  }
+
   /* Un Map Device using MAPD */
   WriteCmdQMAPD(its_index, (uint64_t *)(ItsCommandBase), device_id,
                 g_gic_its_info->GicIts[its_index].ITTBase,
@@ -500,21 +546,29 @@ void val_its_clear_lpi_map(uint32_t its_index, uint32_t device_id, uint32_t int_
   /* ITS SYNC Command */
   WriteCmdQSYNC(its_index, (uint64_t *)(ItsCommandBase), RDBase);
 
-  TestExecuteBarrier();
-  /* Update the CWRITER Register so that all the commands from Command queue gets executed.*/
-  value = ((g_cwriter_ptr[its_index] * NUM_BYTES_IN_DW));
-  val_mmio_write64((ItsBase + ARM_GITS_CWRITER), value);
-
-  /* Check CREADR value which ensures Command Queue is processed */
-  PollTillCommandQueueDone(its_index);
-  TestExecuteBarrier();
+  PublishCommands(its_index);
+}
 
+void val_its_clear_lpi_map(uint32_t its_index, uint32_t device_id, uint32_t int_id)
+{
+  val_its_clear_lpi_map_range(its_index, device_id, int_id, 1);
 }
 
-void val_its_create_lpi_map(uint32_t its_index, uint32_t device_id,
-                            uint32_t int_id, uint32_t Priority)
+/**
+  @brief   Map the LPIs int_id to int_id + num_ids - 1 of a device to collection 1.
+           All MAPTI commands are followed by a single INVALL (INV for one LPI)
+           and SYNC, and published with one CWRITER update.
+  @param   its_index  ITS index
+  @param   device_id  Device ID
+  @param   int_id     First LPI, the EventID is int_id - ARM_LPI_MINID
+  @param   num_ids    Number of LPIs
+  @param   Priority   Priority of the LPIs
+  @return  None
+**/
+void val_its_create_lpi_map_range(uint32_t its_index, uint32_t device_id,
+                                  uint32_t int_id, uint32_t num_ids, uint32_t Priority)
 {
-  uint64_t    value;
+  uint32_t    index;
   uint64_t    RDBase;
   uint64_t    ItsBase;
   uint64_t    ItsCommandBase;
@@ -526,7 +580,8 @@ void val_its_create_lpi_map(uint32_t its_index, uint32_t device_id,
   ItsCommandBase = g_gic_its_info->GicIts[its_index].CommandQBase;
 
   /* Set Config table with enable the LPI = int_id, Priority. */
-  SetConfigTable(int_id, Priority);
+  for (index = 0; index < num_ids; index++)
+    SetConfigTable(int_id + index, Priority);
 
   /* Enable Redistributor */
   EnableLPIsRD(g_gic_its_info->GicRdBase);
@@ -544,23 +599,31 @@ void val_its_create_lpi_map(uint32_t its_index, uint32_t device_id,
   /* Map Collection using MAPC */
   WriteCmdQMAPC(its_index, (uint64_t *)(ItsCommandBase),
                 0x1 /*Clctn_ID*/, RDBase, 0x1 /*Valid*/);
-  /* Map Interrupt using MAPI */
-  WriteCmdQMAPTI(its_index, (uint64_t *)(ItsCommandBase), device_id, int_id, 0x1 /*Clctn_ID*/);
+
+  /* Map Interrupts using MAPTI, publishing before the queue can fill up */
+  for (index = 0; index < num_ids; index++) {
+    WriteCmdQMAPTI(its_index, (uint64_t *)(ItsCommandBase), device_id, int_id + index,
+                   0x1 /*Clctn_ID*/);
+    if ((index + 1) % ITS_CMDQ_BATCH_MAX == 0)
+      PublishCommands(its_index);
+  }
+
   /* Invalid Entry */
-  WriteCmdQINV(its_index, (uint64_t *)(ItsCommandBase), device_id, int_id);
+  if (num_ids == 1)
+    WriteCmdQINV(its_index, (uint64_t *)(ItsCommandBase), device_id, int_id);
+  else
+    WriteCmdQINVALL(its_index, (uint64_t *)(ItsCommandBase), 0x1 /*Clctn_ID*/);
+
   /* ITS SYNC Command */
   WriteCmdQSYNC(its_index, (uint64_t *)(ItsCommandBase), RDBase);
 
-  TestExecuteBarrier();
-
-  /* Update the CWRITER Register so that all the commands from Command queue gets executed.*/
-  value = ((g_cwriter_ptr[its_index] * NUM_BYTES_IN_DW));
-  val_mmio_write64((ItsBase + ARM_GITS_CWRITER), value);
-
-  /* Check CREADR value which ensures Command Queue is processed */
-  PollTillCommandQueueDone(its_index);
-  TestExecuteBarrier();
+  PublishCommands(its_index);
+}
 
+void val_its_create_lpi_map(uint32_t its_index, uint32_t device_id,
+                            uint32_t int_id, uint32_t Priority)
+{
+  val_its_create_lpi_map_range(its_index, device_id, int_id, 1, Priority);
 }
 
 
@@ -174,6 +174,7 @@
 #define ARM_ITS_CMD_MAPI    0xB
 #define ARM_ITS_CMD_MAPTI   0xA
 #define ARM_ITS_CMD_INV     0xC
+#define ARM_ITS_CMD_INVALL  0xD
 #define ARM_ITS_CMD_DISCARD 0xF
 #define ARM_ITS_CMD_SYNC    0x5
 
@@ -185,6 +186,10 @@
 #define ITS_NEXT_CMD_PTR    4
 #define NUM_BYTES_IN_DW     8
 
+/* Command queue size in dwords, and MAPTI commands published together by a range map */
+#define ITS_CMDQ_NUM_DW     ((NUM_PAGES_8 * SIZE_4KB) / NUM_BYTES_IN_DW)
+#define ITS_CMDQ_BATCH_MAX  512
+
 uint32_t ArmGicRedistributorConfigurationForLPI(uint64_t rd_base);
 
 void ClearConfigTable(uint32_t int_id);
@@ -198,6 +203,10 @@ void EnableLPIsRD(uint64_t rd_base);
 void val_its_create_lpi_map(uint32_t its_index, uint32_t device_id,
                             uint32_t int_id, uint32_t Priority);
 void val_its_clear_lpi_map(uint32_t its_index, uint32_t device_id, uint32_t int_id);
+void val_its_create_lpi_map_range(uint32_t its_index, uint32_t device_id,
+                                  uint32_t int_id, uint32_t num_ids, uint32_t Priority);
+void val_its_clear_lpi_map_range(uint32_t its_index, uint32_t device_id,
+                                 uint32_t int_id, uint32_t num_ids);
 
 uint64_t val_its_get_translater_addr(uint32_t its_index);
 uint32_t val_its_get_max_lpi(void);
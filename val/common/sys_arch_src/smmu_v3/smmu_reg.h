@@ -198,7 +198,18 @@ BITFIELD_DECL(uint64_t, CMDQ_0_OP, 7, 0)
 BITFIELD_DECL(uint64_t, CMDQ_CFGI_1_RANGE, 4, 0)
 #define CMDQ_CFGI_1_ALL_STES 31
 
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_CS, 13, 12)
+#define CMDQ_SYNC_0_CS_NONE 0
+#define CMDQ_SYNC_0_CS_IRQ  1
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_MSH, 23, 22)
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_MSIATTR, 27, 24)
+#define CMDQ_SYNC_0_MSIATTR_OIWB 0xf
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_MSIDATA, 63, 32)
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_1_MSIADDR, 51, 2)
+
 #define SMMU_CMDQ_POLL_TIMEOUT 0x100000
+/* CMD_SYNC MSI poll, a cached memory read is far cheaper than a CONS MMIO read */
+#define SMMU_CMDQ_MSI_POLL_TIMEOUT (SMMU_CMDQ_POLL_TIMEOUT * 64)
 
 #define CDTAB_SPLIT             10
 #define CDTAB_L2_ENTRY_COUNT    (1 << CDTAB_SPLIT)
@@ -1,5 +1,5 @@
 /** @file
- * Copyright (c) 2020, 2022-2024, Arm Limited or its affiliates. All rights reserved.
+ * Copyright (c) 2020, 2022-2025, Arm Limited or its affiliates. All rights reserved.
  * SPDX-License-Identifier : Apache-2.0
 
  * Licensed under the Apache License, Version 2.0 (the "License");
@@ -23,7 +23,7 @@ uint32_t    g_smmu_index;
 uint64_t    g_page1_base;
 extern uint32_t g_num_smmus;
 
-struct smmu_master_node *g_smmu_master_list_head = NULL;
+struct smmu_master_node *g_smmu_master_hash[SMMU_MASTER_HASH_SIZE];
 
 static uint64_t align_to_size(uint64_t addr,  uint64_t size)
 {
@@ -77,51 +77,86 @@ static int smmu_cmdq_build_cmd(uint64_t *cmd, uint8_t opcode)
     return 0;
 }
 
-static int smmu_cmdq_write_cmd(smmu_dev_t *smmu, uint64_t *cmd)
+static uint32_t smmu_queue_space(smmu_queue_t *q)
+{
+    uint32_t nent = (0x1ul << q->log2nent);
+    return nent - ((q->prod - q->cons) & ((nent << 1) - 1));
+}
+
+/**
+  @brief Copy commands to the free slots of the command queue and publish them.
+         PROD is only written by this driver, so it is tracked in software and
+         written once for every run of free slots. CONS is read only when the
+         cached state does not show enough space for the remaining commands.
+  @param smmu - SMMU device.
+  @param cmd - commands, CMDQ_DWORDS_PER_ENT dwords each.
+  @param num_cmds - number of commands.
+  @return 0 on success, -1 if the queue stays full
+**/
+static int smmu_cmdq_write_cmds(smmu_dev_t *smmu, uint64_t *cmd, uint32_t num_cmds)
 {
     uint32_t timeout = SMMU_CMDQ_POLL_TIMEOUT;
-    int ret = 0, i;
+    uint32_t space, n, i;
     uint64_t *cmd_dst;
     smmu_cmd_queue_t *cmdq = &smmu->cmdq;
-    smmu_queue_t
-        queue =
-            {
-                .log2nent = cmdq->queue.log2nent,
-            };
-
-    while (smmu_queue_full(&cmdq->queue) && timeout) {
-        timeout--;
-    }
+    smmu_queue_t *queue = &cmdq->queue;
+    uint32_t ptr_mask = (0x1ul << (queue->log2nent + 1)) - 1;
+
+    while (num_cmds) {
+        space = smmu_queue_space(queue);
+        if (space < num_cmds) {
+            queue->cons = val_mmio_read((uint64_t)cmdq->cons_reg) & ptr_mask;
+            space = smmu_queue_space(queue);
+        }
 
-    if (!timeout) {
-        val_print(ACS_PRINT_ERR, "\n       SMMU CMD queue is full     ", 0);
-        return -1;
-    }
+        if (!space) {
+            if (!--timeout) {
+                val_print(ACS_PRINT_ERR, "\n       SMMU CMD queue is full     ", 0);
+                return -1;
+            }
+            continue;
+        }
 
-    queue.prod = val_mmio_read((uint64_t)cmdq->prod_reg);
-    cmd_dst = (uint64_t *)(cmdq->base + ((queue.prod & ((0x1ull << queue.log2nent) - 1)) * (cmdq->entry_size)));
-    for (i = 0; i < CMDQ_DWORDS_PER_ENT; ++i)
-        cmd_dst[i] = cmd[i];
-    queue.prod = smmu_inc_prod(&queue);
+        n = (space < num_cmds) ? space : num_cmds;
+        for (i = 0; i < n; i++) {
+            cmd_dst = (uint64_t *)(cmdq->base + ((queue->prod & ((0x1ull << queue->log2nent) - 1)) *
+                                                 (cmdq->entry_size)));
+            cmd_dst[0] = cmd[0];
+            cmd_dst[1] = cmd[1];
+            cmd += CMDQ_DWORDS_PER_ENT;
+            queue->prod = smmu_inc_prod(queue);
+        }
 
 #ifndef TARGET_LINUX
-    ArmExecuteMemoryBarrier();
+        ArmExecuteMemoryBarrier();
 #endif
-    val_mmio_write((uint64_t)cmdq->prod_reg, queue.prod);
+        val_mmio_write((uint64_t)cmdq->prod_reg, queue->prod);
+        num_cmds -= n;
+    }
 
-    return ret;
+    return 0;
 }
 
-static int smmu_cmdq_issue_cmd(smmu_dev_t *smmu,
-                   uint8_t opcode)
+/**
+  @brief Add a command to a batch. A full batch is published without waiting.
+  @param smmu - SMMU device.
+  @param batch - batch to add the command to.
+  @param opcode - command opcode.
+  @return 0 on success
+**/
+static int smmu_cmdq_batch_add(smmu_dev_t *smmu, smmu_cmdq_batch_t *batch, uint8_t opcode)
 {
-    uint64_t cmd[CMDQ_DWORDS_PER_ENT];
+    if (batch->num == SMMU_CMDQ_BATCH_MAX) {
+        if (smmu_cmdq_write_cmds(smmu, batch->cmds, batch->num))
+            return -1;
+        batch->num = 0;
+    }
 
-    if (smmu_cmdq_build_cmd(cmd, opcode)) {
+    if (smmu_cmdq_build_cmd(&batch->cmds[batch->num * CMDQ_DWORDS_PER_ENT], opcode))
         return -1;
-    }
 
-    return smmu_cmdq_write_cmd(smmu, cmd);
+    batch->num++;
+    return 0;
 }
 
 static void smmu_cmdq_poll_until_consumed(smmu_dev_t *smmu)
@@ -152,6 +187,76 @@ val_mmio_read(smmu->base + SMMU_GERROR_OFFSET));
     }
 }
 
+/**
+  @brief Publish a batch followed by one CMD_SYNC, and wait for the CMD_SYNC.
+         When the SMMU supports coherent MSIs the CMD_SYNC writes a sequence
+         number to memory, which is polled instead of the CONS register. The
+         memory poll has its own timeout, and CONS is checked before a timeout
+         is reported, in case the MSI write was not observed.
+  @param smmu - SMMU device.
+  @param batch - commands to publish, emptied on return.
+  @return 0 on success
+**/
+static int smmu_cmdq_batch_submit(smmu_dev_t *smmu, smmu_cmdq_batch_t *batch)
+{
+    uint32_t timeout = SMMU_CMDQ_MSI_POLL_TIMEOUT;
+    uint64_t *cmd;
+    uint64_t msi_addr;
+    smmu_cmd_queue_t *cmdq = &smmu->cmdq;
+    smmu_queue_t queue;
+    uint32_t use_msi = smmu->supported.msi && smmu->supported.coherent;
+
+    if (batch->num == SMMU_CMDQ_BATCH_MAX) {
+        if (smmu_cmdq_write_cmds(smmu, batch->cmds, batch->num))
+            return -1;
+        batch->num = 0;
+    }
+
+    cmd = &batch->cmds[batch->num * CMDQ_DWORDS_PER_ENT];
+    smmu_cmdq_build_cmd(cmd, CMDQ_OP_CMD_SYNC);
+    if (use_msi) {
+        cmdq->sync_count++;
+        msi_addr = (uint64_t)val_memory_virt_to_phys((void *)&cmdq->sync_msi);
+        cmd[0] |= BITFIELD_SET(CMDQ_SYNC_0_CS, CMDQ_SYNC_0_CS_IRQ) |
+                  BITFIELD_SET(CMDQ_SYNC_0_MSH, SMMU_SH_ISH) |
+                  BITFIELD_SET(CMDQ_SYNC_0_MSIATTR, CMDQ_SYNC_0_MSIATTR_OIWB) |
+                  BITFIELD_SET(CMDQ_SYNC_0_MSIDATA, cmdq->sync_count);
+        cmd[1] |= BITFIELD_SET(CMDQ_SYNC_1_MSIADDR, msi_addr >> 2);
+    }
+    batch->num++;
+
+    if (smmu_cmdq_write_cmds(smmu, batch->cmds, batch->num))
+        return -1;
+    batch->num = 0;
+
+    if (!use_msi) {
+        smmu_cmdq_poll_until_consumed(smmu);
+        return 0;
+    }
+
+    while (cmdq->sync_msi != cmdq->sync_count && timeout)
+        timeout--;
+
+    if (!timeout) {
+        /* The CMD_SYNC is complete once CONS has passed it */
+        queue.log2nent = cmdq->queue.log2nent;
+        queue.prod = cmdq->queue.prod;
+        queue.cons = val_mmio_read((uint64_t)cmdq->cons_reg) &
+                     ((0x1ul << (queue.log2nent + 1)) - 1);
+        if (smmu_queue_empty(&queue)) {
+            val_print(ACS_PRINT_WARN, "\n       CMD_SYNC MSI not seen, sync = 0x%x", cmdq->sync_count);
+            return 0;
+        }
+
+        val_print(ACS_PRINT_ERR, "\n       CMD_SYNC MSI timeout, sync = 0x%x", cmdq->sync_count);
+        val_print(ACS_PRINT_ERR, "\n       gerror   = 0x%08x     ",
+                  val_mmio_read(smmu->base + SMMU_GERROR_OFFSET));
+        return -1;
+    }
+
+    return 0;
+}
+
 static void smmu_strtab_write_ste(smmu_master_t *master, uint64_t *ste)
 {
     uint64_t val = STRTAB_STE_0_V;
@@ -288,6 +393,16 @@ static uint32_t smmu_evnt_queue_init(smmu_dev_t *smmu)
                        BITFIELD_SET(QUEUE_BASE_LOG2SIZE, evntq->queue.log2nent);
 
     evntq->queue.prod = evntq->queue.cons = 0;
+
+    /* Events are drained into this buffer, one entry is enough if it can't be allocated */
+    evntq->drain_max = (0x1ul << evntq->queue.log2nent);
+    evntq->drain_max = (evntq->drain_max > SMMU_EVTQ_DRAIN_MAX) ? SMMU_EVTQ_DRAIN_MAX :
+                                                                  evntq->drain_max;
+    evntq->drain_buf = val_memory_alloc(evntq->drain_max * evntq->entry_size);
+    if (!evntq->drain_buf)
+        evntq->drain_max = 0;
+    val_memory_arena_keep(evntq->drain_buf);
+
     return 1;
 }
 
@@ -345,6 +460,8 @@ static int smmu_strtab_init_level2(smmu_dev_t *smmu, uint32_t sid)
 sid);
         return 0;
     }
+    /* Level 2 tables stay linked in the stream table until the SMMU is stopped */
+    val_memory_arena_keep(desc->l2ptr);
 
     desc->l2desc_phys = align_to_size((uint64_t)val_memory_virt_to_phys(desc->l2ptr), size);
     desc->l2desc64 = (uint64_t*)align_to_size((uint64_t)desc->l2ptr, size);
@@ -442,17 +559,47 @@ static int smmu_reg_write_sync(smmu_dev_t *smmu, uint32_t val,
     return 1;
 }
 
-static smmu_master_t *smmu_master_at(uint32_t sid)
+static uint32_t smmu_master_hash(uint32_t smmu_index, uint32_t sid)
 {
-    struct smmu_master_node *node = g_smmu_master_list_head;
+    return ((sid ^ (smmu_index << 24)) * 0x9E3779B1u) >> (32 - SMMU_MASTER_HASH_BITS);
+}
+
+/**
+  @brief Find the master of a stream id behind an SMMU.
+  @param smmu_index - index of the SMMU.
+  @param sid - stream id.
+  @return master, NULL if the stream id has no master
+**/
+static smmu_master_t *smmu_master_find(uint32_t smmu_index, uint32_t sid)
+{
+    struct smmu_master_node *node = g_smmu_master_hash[smmu_master_hash(smmu_index, sid)];
 
     while (node != NULL)
     {
-        if (node->master->sid == sid)
+        if (node->sid == sid && node->smmu_index == smmu_index)
             return node->master;
         node = node->next;
     }
 
+    return NULL;
+}
+
+/**
+  @brief Find the master of a stream id behind an SMMU, allocating it on first use.
+  @param smmu_index - index of the SMMU.
+  @param sid - stream id.
+  @return master, NULL on allocation failure
+**/
+static smmu_master_t *smmu_master_at(uint32_t smmu_index, uint32_t sid)
+{
+    struct smmu_master_node *node;
+    smmu_master_t *master;
+    uint32_t hash;
+
+    master = smmu_master_find(smmu_index, sid);
+    if (master != NULL)
+        return master;
+
     node = val_memory_alloc(sizeof(struct smmu_master_node));
     if (node == NULL)
         return NULL;
@@ -464,8 +611,15 @@ static smmu_master_t *smmu_master_at(uint32_t sid)
         return NULL;
     }
 
-    node->next = g_smmu_master_list_head;
-    g_smmu_master_list_head = node;
+    /* Masters are created by tests and found again by later ones, keep them out of the arenas */
+    val_memory_arena_keep(node);
+    val_memory_arena_keep(node->master);
+
+    hash = smmu_master_hash(smmu_index, sid);
+    node->smmu_index = smmu_index;
+    node->sid = sid;
+    node->next = g_smmu_master_hash[hash];
+    g_smmu_master_hash[hash] = node;
 
     return node->master;
 }
@@ -553,17 +707,35 @@ static void smmu_queue_read(smmu_evnt_queue_t *evntq, uint64_t *event)
 }
 
 
-static int smmu_queue_remove_raw(smmu_evnt_queue_t *evntq, uint64_t *event)
+/**
+  @brief Copy the events between CONS and the last PROD snapshot to a buffer,
+         then publish CONS once, acknowledging any queue overflow.
+  @param evntq - event queue.
+  @param event - buffer of max_events entries.
+  @param max_events - buffer size in events.
+  @return number of events copied
+**/
+static uint32_t smmu_evtq_drain(smmu_evnt_queue_t *evntq, uint64_t *event, uint32_t max_events)
 {
-    if (smmu_queue_empty(&evntq->queue))
+    uint32_t num = 0;
+
+    while (num < max_events && !smmu_queue_empty(&evntq->queue))
     {
-        return 1;
+        smmu_queue_read(evntq, event);
+        event += EVNTQ_DWORDS_PER_ENT;
+        evntq->queue.cons = smmu_inc_cons(&evntq->queue);
+        num++;
     }
 
-    smmu_queue_read(evntq, event);
-    evntq->queue.cons = smmu_inc_cons(&evntq->queue);
-    val_mmio_write((uint64_t)evntq->cons_reg, evntq->queue.cons);
-    return 0;
+    if (num) {
+#ifndef TARGET_LINUX
+        ArmExecuteMemoryBarrier();
+#endif
+        val_mmio_write((uint64_t)evntq->cons_reg,
+                       evntq->queue.cons | SMMU_QUEUE_OVF(evntq->queue.prod));
+    }
+
+    return num;
 }
 
 static int queue_sync_prod_in(smmu_evnt_queue_t *evntq)
@@ -601,11 +773,12 @@ static uint32_t smmu_gerror_check(smmu_dev_t *smmu)
 
 static void smmu_evtq_thread(void)
 {
-    uint32_t i, ret;
+    uint32_t i, n, num, max_events, ret;
     smmu_dev_t *smmu = &g_smmu[g_smmu_index];
     smmu_evnt_queue_t *evntq = &smmu->evntq;
-    smmu_queue_t *queue = &evntq->queue;
-    uint64_t event[EVNTQ_DWORDS_PER_ENT];
+    uint64_t local_event[EVNTQ_DWORDS_PER_ENT];
+    uint64_t *events, *event;
+
     ret = smmu_gerror_check(smmu);
     if (ret)
     {
@@ -613,33 +786,38 @@ static void smmu_evtq_thread(void)
         return;
     }
 
-    do {
-        while (!smmu_queue_remove_raw(evntq, event)) {
-            uint8_t id = BITFIELD_GET(EVTQ_0_ID, event[0]);
+    events = evntq->drain_buf;
+    max_events = evntq->drain_max;
+    if (events == NULL) {
+        events = local_event;
+        max_events = 1;
+    }
+
+    /* Copy out everything up to a PROD snapshot and release it to the SMMU before decoding */
+    while (1) {
+        if (queue_sync_prod_in(evntq))
+            val_print(ACS_PRINT_WARN, "\n  EVTQ overflow detected -- events lost     ", 0);
+
+        num = smmu_evtq_drain(evntq, events, max_events);
+        if (!num)
+            break;
+
+        val_print(ACS_PRINT_INFO, "\n  prod is: %x", evntq->queue.prod);
+        val_print(ACS_PRINT_INFO, "\n  cons is: %x", evntq->queue.cons);
+
+        for (n = 0; n < num; n++) {
+            event = &events[n * EVNTQ_DWORDS_PER_ENT];
             ret = smmu_handle_evt(event);
-            val_print(ACS_PRINT_TEST, "\n  event 0x%02x received: %d     ", id);
-            for (i = 0; i < ARRAY_SIZE(event); ++i)
+            val_print(ACS_PRINT_TEST, "\n  event 0x%02x received:     ",
+                      BITFIELD_GET(EVTQ_0_ID, event[0]));
+            for (i = 0; i < EVNTQ_DWORDS_PER_ENT; ++i)
             {
                 val_print(ACS_PRINT_TEST, "\n  0x%016llx     ", (unsigned long long)event[i]);
             }
-
-            val_print(ACS_PRINT_INFO, "\n  prod is: %x", val_mmio_read((uint64_t)evntq->prod_reg));
-            val_print(ACS_PRINT_INFO, "\n  cons is: %x", val_mmio_read((uint64_t)evntq->cons_reg));
         }
-
-        if (queue_sync_prod_in(evntq))
-            val_print(ACS_PRINT_WARN, "\n  EVTQ overflow detected -- events lost     ", 0);
-    } while (!smmu_queue_empty(&evntq->queue));
-
-    if (val_mmio_read((uint64_t)evntq->prod_reg) == val_mmio_read((uint64_t)evntq->cons_reg))
-    {
-        val_print(ACS_PRINT_TEST, "\n  No outstanding events in the queue. Queue Empty.\n", 0);
     }
 
-    evntq->queue.cons = ((queue->prod) & (1 << 31)) |
-                        ((queue->cons) & (1 << queue->log2nent)) |
-                        ((queue->cons) & ((1 << queue->log2nent) - 1));
-return;
+    val_print(ACS_PRINT_TEST, "\n  No outstanding events in the queue. Queue Empty.\n", 0);
 }
 
 static int smmu_dev_disable(smmu_dev_t *smmu)
@@ -655,16 +833,18 @@ static int smmu_dev_disable(smmu_dev_t *smmu)
 
 static void smmu_tlbi_cfgi(smmu_dev_t *smmu)
 {
+    smmu_cmdq_batch_t batch;
+
+    batch.num = 0;
+
     /* Invalidate any cached configuration */
-    smmu_cmdq_issue_cmd(smmu, CMDQ_OP_CFGI_ALL);
+    smmu_cmdq_batch_add(smmu, &batch, CMDQ_OP_CFGI_ALL);
     if (smmu->supported.hyp) {
-        smmu_cmdq_issue_cmd(smmu, CMDQ_OP_TLBI_EL2_ALL);
+        smmu_cmdq_batch_add(smmu, &batch, CMDQ_OP_TLBI_EL2_ALL);
     }
 
-    smmu_cmdq_issue_cmd(smmu, CMDQ_OP_TLBI_NSNH_ALL);
-    smmu_cmdq_issue_cmd(smmu, CMDQ_OP_CMD_SYNC);
-
-    smmu_cmdq_poll_until_consumed(smmu);
+    smmu_cmdq_batch_add(smmu, &batch, CMDQ_OP_TLBI_NSNH_ALL);
+    smmu_cmdq_batch_submit(smmu, &batch);
 }
 
 static int smmu_reset(smmu_dev_t *smmu)
@@ -801,6 +981,12 @@ static uint32_t smmu_probe(smmu_dev_t *smmu)
     if (data & IDR0_HYP)
         smmu->supported.hyp = 1;
 
+    if (data & IDR0_MSI)
+        smmu->supported.msi = 1;
+
+    if (data & IDR0_COHACC)
+        smmu->supported.coherent = 1;
+
     if (data & IDR0_S1P)
         smmu->supported.s1p = 1;
 
@@ -909,6 +1095,7 @@ static int smmu_cdtab_alloc_leaf_table(smmu_cdtab_l1_ctx_desc_t *l1_desc)
         val_print(ACS_PRINT_ERR, "\n       failed to allocate context descriptor table     ", 0);
         return 1;
     }
+    val_memory_arena_keep(l1_desc->l2ptr);
 
     l1_desc->l2desc_phys = align_to_size((uint64_t)val_memory_virt_to_phys(l1_desc->l2ptr), size);
     l1_desc->l2desc64 = (uint64_t*)align_to_size((uint64_t)l1_desc->l2ptr, size);
@@ -1018,6 +1205,7 @@ static int smmu_cdtab_alloc(smmu_master_t *master)
         cdcfg->l1_desc = val_memory_calloc(cdcfg->l1_ent_count, sizeof(*cdcfg->l1_desc));
         if (!cdcfg->l1_desc)
             return 0;
+        val_memory_arena_keep(cdcfg->l1_desc);
 
         l1_tbl_size = cdcfg->l1_ent_count * (CDTAB_L1_DESC_DWORDS << 3);
     } else {
@@ -1032,6 +1220,9 @@ static int smmu_cdtab_alloc(smmu_master_t *master)
         return 0;
     }
 
+    /* The context descriptors belong to the master, freed by val_smmu_unmap */
+    val_memory_arena_keep(cdcfg->cdtab_ptr);
+
     cdcfg->cdtab_phys = align_to_size((uint64_t)val_memory_virt_to_phys(cdcfg->cdtab_ptr), l1_tbl_size);
     cdcfg->cdtab64 = (uint64_t*)align_to_size((uint64_t)cdcfg->cdtab_ptr, l1_tbl_size);
 
@@ -1072,7 +1263,7 @@ uint64_t val_smmu_map(smmu_master_attributes_t master_attr, pgt_descriptor_t pgt
         return 1;
     }
 
-    if ((master = smmu_master_at(master_attr.streamid)) == NULL)
+    if ((master = smmu_master_at(master_attr.smmu_index, master_attr.streamid)) == NULL)
         return 1;
 
     if (master->smmu == NULL)
@@ -1170,7 +1361,7 @@ uint32_t val_smmu_config_ste_dcp(smmu_master_attributes_t master_attr, uint32_t
     uint64_t *ste;
     uint32_t dcp_value;
 
-    master = smmu_master_at(master_attr.streamid);
+    master = smmu_master_find(master_attr.smmu_index, master_attr.streamid);
     if (master == NULL)
         return ACS_INVALID_INDEX;
 
@@ -1202,7 +1393,7 @@ void val_smmu_unmap(smmu_master_attributes_t master_attr)
     smmu_master_t *master;
     uint64_t *strtab;
 
-    if ((master = smmu_master_at(master_attr.streamid)) == NULL)
+    if ((master = smmu_master_find(master_attr.smmu_index, master_attr.streamid)) == NULL)
         return;
 
     if (master->smmu == NULL)
@@ -1265,6 +1456,8 @@ void val_smmu_stop(void)
             val_memory_free(smmu->cmdq.base_ptr);
         if (smmu->evntq.base_ptr)
             val_memory_free(smmu->evntq.base_ptr);
+        if (smmu->evntq.drain_buf)
+            val_memory_free(smmu->evntq.drain_buf);
         smmu_free_strtab(smmu);
     }
 
@@ -54,8 +54,18 @@ typedef struct {
     uint64_t entry_size;
     uint32_t *prod_reg;
     uint32_t *cons_reg;
+    volatile uint32_t sync_msi;   /* CMD_SYNC completion word written by the SMMU */
+    uint32_t sync_count;
 } smmu_cmd_queue_t;
 
+/* Commands collected by smmu_cmdq_batch_add and published together */
+#define SMMU_CMDQ_BATCH_MAX 16
+
+typedef struct {
+    uint64_t cmds[SMMU_CMDQ_BATCH_MAX * CMDQ_DWORDS_PER_ENT];
+    uint32_t num;
+} smmu_cmdq_batch_t;
+
 typedef struct {
     smmu_queue_t queue;
     void    *base_ptr;
@@ -65,8 +75,13 @@ typedef struct {
     uint64_t entry_size;
     uint32_t *prod_reg;
     uint32_t *cons_reg;
+    uint64_t *drain_buf;          /* Events copied out by smmu_evtq_drain */
+    uint32_t drain_max;
 } smmu_evnt_queue_t;
 
+/* Maximum events copied out of the event queue before CONS is published */
+#define SMMU_EVTQ_DRAIN_MAX 256
+
 typedef struct {
     uint8_t  span;
     void     *l2ptr;
@@ -136,6 +151,7 @@ typedef struct {
            uint32_t s1p:1;
            uint32_t s2p:1;
            uint32_t msi:1;
+           uint32_t coherent:1;
         };
         uint32_t bitmap;
     } supported;
@@ -159,8 +175,14 @@ typedef struct {
     uint32_t ssid_bits;
 } smmu_master_t;
 
+/* Masters are hashed on (smmu index, stream id) into SMMU_MASTER_HASH_SIZE buckets */
+#define SMMU_MASTER_HASH_BITS 8
+#define SMMU_MASTER_HASH_SIZE (0x1u << SMMU_MASTER_HASH_BITS)
+
 struct smmu_master_node {
     smmu_master_t *master;
+    uint32_t smmu_index;
+    uint32_t sid;
     struct smmu_master_node *next;
 };
 